@@ -0,0 +1,216 @@
+#include "BakedScene.hpp"
+
+#include "Scene.hpp"
+#include "read_write_chunk.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+//FNV-1a, seeded, with a final mix (FNV's low bits are weak and slots are taken modulo small sizes):
+static uint32_t name_hash(std::string_view name, uint32_t seed) {
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (char c : name) {
+		h ^= uint8_t(c);
+		h *= 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	return h;
+}
+
+BakedScene::BakedScene(std::string const &filename) : reader(filename) {
+	headers = reader.read< Header >("bkh3");
+	strings = reader.read< char >("str0");
+	transforms = reader.read< Transform >("xfm0");
+	colliders = reader.read< Collider >("col0");
+	invisible = reader.read< uint32_t >("inv0");
+	hash_seeds = reader.read< uint32_t >("phb0");
+	hash_slots = reader.read< uint32_t >("phs0");
+
+	if (headers.size() != 1 || header().version != Version) {
+		throw std::runtime_error("baked scene '" + filename + "' has an unsupported header/version.");
+	}
+	if (transforms.size() != header().transform_count) {
+		throw std::runtime_error("baked scene '" + filename + "' has the wrong number of transforms.");
+	}
+	for (auto const &c : colliders) {
+		if (c.transform >= transforms.size() || c.category > Bread) {
+			throw std::runtime_error("baked scene '" + filename + "' contains an invalid collider entry.");
+		}
+	}
+	for (uint32_t i : invisible) {
+		if (i >= transforms.size()) {
+			throw std::runtime_error("baked scene '" + filename + "' contains an invalid hidden transform index.");
+		}
+	}
+	if (hash_slots.size() > transforms.size() || (!hash_slots.empty() && hash_seeds.empty())) {
+		throw std::runtime_error("baked scene '" + filename + "' contains an invalid name table.");
+	}
+	for (uint32_t i : hash_slots) {
+		if (i >= transforms.size()) {
+			throw std::runtime_error("baked scene '" + filename + "' contains an invalid name table entry.");
+		}
+	}
+	if (!reader.at_end()) {
+		throw std::runtime_error("baked scene '" + filename + "' has trailing data.");
+	}
+}
+
+uint32_t BakedScene::find(std::string_view name_) const {
+	if (hash_slots.empty()) return Invalid;
+	uint32_t bucket = name_hash(name_, 0) % hash_seeds.size();
+	uint32_t index = hash_slots[name_hash(name_, hash_seeds[bucket]) % hash_slots.size()];
+	Transform const &t = transforms[index];
+	return name(t.name_begin, t.name_end) == name_ ? index : Invalid;
+}
+
+BakedScene::Source BakedScene::source(std::string const &filename) {
+	#if defined(_WIN32)
+	struct _stat64 info;
+	if (_stat64(filename.c_str(), &info) != 0) {
+	#else
+	struct stat info;
+	if (stat(filename.c_str(), &info) != 0) {
+	#endif
+		throw std::runtime_error("Failed to stat '" + filename + "'.");
+	}
+	Source ret;
+	ret.size = uint64_t(info.st_size);
+	ret.mtime = int64_t(info.st_mtime);
+	return ret;
+}
+
+bool BakedScene::up_to_date(std::string const &scene_file, std::string const &meshes_file) const {
+	auto same = [](Source const &a, Source const &b) {
+		return a.size == b.size && a.mtime == b.mtime;
+	};
+	return same(header().scene_source, source(scene_file)) && same(header().meshes_source, source(meshes_file));
+}
+
+void BakedScene::write(std::string const &filename, Scene const &scene, std::string const &scene_file, std::string const &meshes_file) {
+	std::vector< char > out_strings;
+	auto add_string = [&out_strings](std::string const &str, uint32_t *begin, uint32_t *end) {
+		*begin = uint32_t(out_strings.size());
+		out_strings.insert(out_strings.end(), str.begin(), str.end());
+		*end = uint32_t(out_strings.size());
+	};
+
+	//transforms, in scene (= .scene file) order:
+	std::vector< Transform > out_transforms;
+	std::unordered_map< Scene::Transform const *, uint32_t > transform_index;
+	for (auto const &t : scene.transforms) {
+		transform_index.emplace(&t, uint32_t(out_transforms.size()));
+		out_transforms.emplace_back();
+		add_string(t.name, &out_transforms.back().name_begin, &out_transforms.back().name_end);
+		out_transforms.back().local_to_world = t.make_local_to_world();
+	}
+
+	auto index_of = [&](Scene::Transform const *t) {
+		auto f = transform_index.find(t);
+		if (f == transform_index.end()) throw std::runtime_error("baking a drawable whose transform isn't in the scene");
+		return f->second;
+	};
+	auto drawable_transform = [&](std::string const &name) {
+		auto f = scene.drawble_name_map.find(name);
+		if (f == scene.drawble_name_map.end()) throw std::runtime_error("baking collider '" + name + "', which has no drawable");
+		return index_of(f->second->transform);
+	};
+
+	//colliders, in the order Scene's setup functions list them:
+	std::vector< Collider > out_colliders;
+	auto add_colliders = [&](std::list< std::shared_ptr< Scene::Collider > > const &list, Category category) {
+		for (auto const &c : list) {
+			Collider out;
+			add_string(c->name, &out.name_begin, &out.name_end);
+			out.category = category;
+			out.transform = drawable_transform(c->name);
+			out.min_original = c->min_original;
+			out.max_original = c->max_original;
+			out.min = c->min;
+			out.max = c->max;
+			out.bounce_midpoint = out.bounce_destination = glm::vec3(0.0f);
+			auto bounce = scene.bread_bouncelocation_map.find(c);
+			if (bounce != scene.bread_bouncelocation_map.end()) {
+				out.bounce_midpoint = bounce->second.first;
+				out.bounce_destination = bounce->second.second;
+			}
+			out_colliders.emplace_back(out);
+		}
+	};
+	add_colliders(scene.colliders, Plain);
+	add_colliders(scene.terminals, Terminal);
+	add_colliders(scene.text_colliders, Text);
+	add_colliders(scene.bread_colliders, Bread);
+
+	std::vector< uint32_t > out_invisible;
+	for (auto const &d : scene.drawables) {
+		if (d->is_invisible) out_invisible.emplace_back(index_of(d->transform));
+	}
+
+	//minimal perfect hash over the (distinct) transform names ("hash, displace"):
+	// names go into buckets by a fixed hash; then, biggest bucket first, each bucket gets the first
+	// seed that sends all its names to distinct free slots
+	auto name_of = [&](uint32_t i) {
+		return std::string_view(out_strings.data() + out_transforms[i].name_begin, out_transforms[i].name_end - out_transforms[i].name_begin);
+	};
+	std::vector< uint32_t > names; //first transform with each name
+	{
+		std::unordered_map< std::string_view, uint32_t > seen;
+		for (uint32_t i = 0; i < out_transforms.size(); ++i) {
+			if (seen.emplace(name_of(i), i).second) names.emplace_back(i);
+		}
+	}
+	std::vector< uint32_t > out_seeds(std::max< size_t >(1, (names.size() + 3) / 4), 0);
+	std::vector< uint32_t > out_slots(names.size(), Invalid);
+	{
+		std::vector< std::vector< uint32_t > > buckets(out_seeds.size());
+		for (uint32_t i : names) {
+			buckets[name_hash(name_of(i), 0) % buckets.size()].emplace_back(i);
+		}
+		std::vector< uint32_t > order(buckets.size());
+		for (uint32_t b = 0; b < order.size(); ++b) order[b] = b;
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+		std::vector< uint32_t > slots;
+		for (uint32_t b : order) {
+			if (buckets[b].empty()) break;
+			uint32_t seed = 1;
+			for (; seed != 0; ++seed) {
+				slots.clear();
+				for (uint32_t i : buckets[b]) {
+					uint32_t slot = name_hash(name_of(i), seed) % out_slots.size();
+					if (out_slots[slot] != Invalid || std::find(slots.begin(), slots.end(), slot) != slots.end()) break;
+					slots.emplace_back(slot);
+				}
+				if (slots.size() == buckets[b].size()) break;
+			}
+			if (seed == 0) throw std::runtime_error("couldn't build a perfect hash for the scene's names");
+			out_seeds[b] = seed;
+			for (uint32_t j = 0; j < slots.size(); ++j) {
+				out_slots[slots[j]] = buckets[b][j];
+			}
+		}
+	}
+
+	Header header;
+	header.transform_count = uint32_t(out_transforms.size());
+	header.scene_source = source(scene_file);
+	header.meshes_source = source(meshes_file);
+
+	std::ofstream out(filename, std::ios::binary);
+	write_chunk("bkh3", std::vector< Header >{header}, &out);
+	write_chunk("str0", out_strings, &out);
+	write_chunk("xfm0", out_transforms, &out);
+	write_chunk("col0", out_colliders, &out);
+	write_chunk("inv0", out_invisible, &out);
+	write_chunk("phb0", out_seeds, &out);
+	write_chunk("phs0", out_slots, &out);
+	if (!out) {
+		throw std::runtime_error("failed to write baked scene '" + filename + "'.");
+	}
+}
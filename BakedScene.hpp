@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * A level's scene setup, baked offline (by bake-scene) so loading it is a validate-and-map step:
+ *  - the world matrix of every transform, in the .scene file's order (these seed the transforms' cached matrices)
+ *  - every collider's mesh-space and world-space bounds, by category (plain, terminal, text, bread),
+ *    plus each bread's bounce points
+ *  - the transforms Scene setup hides (bread bounce locations)
+ *  - a minimal perfect hash table over the transform names, for find()
+ *
+ * The file is read_chunk()-format chunks, read in place through a ChunkReader:
+ *   "bkh3": Header (version + size and modification time of the .scene/.pnct it was baked from)
+ *   "str0": names; "xfm0": Transform; "col0": Collider; "inv0": hidden transform indices
+ *   "phb0": per-bucket hash seeds; "phs0": slot -> transform index
+ *
+ * Scene::initialize_baked() maps a Scene's transforms to their records with find() and builds its colliders from them.
+ */
+
+#include "ChunkReader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Scene;
+struct MeshBuffer;
+
+struct BakedScene {
+	static constexpr uint32_t Version = 3;
+	static constexpr uint32_t Invalid = -1U;
+
+	//a source file as it was when baked (a changed size or modification time makes the bake stale):
+	struct Source {
+		uint64_t size = 0;
+		int64_t mtime = 0; //seconds since the epoch
+	};
+	static_assert(sizeof(Source) == 8 + 8, "Source is packed.");
+
+	struct Header {
+		uint32_t version = Version;
+		uint32_t transform_count = 0;
+		Source scene_source, meshes_source;
+	};
+	static_assert(sizeof(Header) == 4 + 4 + 2*16, "Header is packed.");
+
+	struct Transform {
+		uint32_t name_begin, name_end;
+		glm::mat4x3 local_to_world;
+	};
+	static_assert(sizeof(Transform) == 4 + 4 + 4*12, "Transform is packed.");
+
+	enum Category : uint32_t {
+		Plain = 0, //Scene::colliders
+		Terminal = 1, //Scene::terminals
+		Text = 2, //Scene::text_colliders
+		Bread = 3, //Scene::bread_colliders
+	};
+	struct Collider {
+		uint32_t name_begin, name_end;
+		uint32_t category;
+		uint32_t transform;
+		glm::vec3 min_original, max_original; //mesh bounds
+		glm::vec3 min, max; //world bounds
+		glm::vec3 bounce_midpoint, bounce_destination; //(Bread only)
+	};
+	static_assert(sizeof(Collider) == 4*4 + 4*3*6, "Collider is packed.");
+
+	//load a baked scene:
+	// note: will throw if the file is malformed or has a different version
+	explicit BakedScene(std::string const &filename);
+
+	//bake a scene (already set up with initialize_scene_metadata / initialize_*collider / initialize_bread):
+	static void write(std::string const &filename, Scene const &scene, std::string const &scene_file, std::string const &meshes_file);
+
+	//size and modification time of a file (no reading it):
+	// note: will throw if the file can't be found
+	static Source source(std::string const &filename);
+
+	//were these the files this was baked from, unchanged since?
+	bool up_to_date(std::string const &scene_file, std::string const &meshes_file) const;
+
+	Header const &header() const { return headers[0]; }
+
+	//index of the (first) transform with this name, or Invalid:
+	uint32_t find(std::string_view name) const;
+
+	std::string_view name(uint32_t name_begin, uint32_t name_end) const { return reader.string(strings, name_begin, name_end); }
+
+	ChunkReader reader;
+	ChunkSpan< Header > headers;
+	ChunkSpan< char > strings;
+	ChunkSpan< Transform > transforms;
+	ChunkSpan< Collider > colliders;
+	ChunkSpan< uint32_t > invisible;
+	ChunkSpan< uint32_t > hash_seeds;
+	ChunkSpan< uint32_t > hash_slots;
+};
@@ -0,0 +1,122 @@
+#include "ChunkReader.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string const &filename) {
+	#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open '" + filename + "'.");
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		throw std::runtime_error("Failed to get size of '" + filename + "'.");
+	}
+	size = size_t(file_size.QuadPart);
+	if (size != 0) {
+		//(the mapping object keeps the file open)
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (mapping == NULL) {
+			throw std::runtime_error("Failed to map '" + filename + "'.");
+		}
+		data = reinterpret_cast< char const * >(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr) {
+			CloseHandle(mapping);
+			throw std::runtime_error("Failed to map '" + filename + "'.");
+		}
+		handle = mapping;
+	} else {
+		CloseHandle(file);
+	}
+	#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open '" + filename + "'.");
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw std::runtime_error("Failed to get size of '" + filename + "'.");
+	}
+	size = size_t(info.st_size);
+	if (size != 0) {
+		void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("Failed to map '" + filename + "'.");
+		}
+		//chunks are read front-to-back, once:
+		madvise(mapped, size, MADV_SEQUENTIAL);
+		data = reinterpret_cast< char const * >(mapped);
+	}
+	//(the mapping stays valid after the descriptor is closed)
+	close(fd);
+	#endif
+}
+
+MappedFile::~MappedFile() {
+	if (data == nullptr) return;
+	#if defined(_WIN32)
+	UnmapViewOfFile(data);
+	CloseHandle(reinterpret_cast< HANDLE >(handle));
+	#else
+	munmap(const_cast< char * >(data), size);
+	#endif
+}
+
+//--------------------------------------------------------------
+
+ChunkReader::ChunkReader(std::string const &filename_) : filename(filename_), file(filename_) {
+}
+
+char const *ChunkReader::read_raw(std::string const &magic, size_t element_size, size_t *size_) {
+	assert(magic.size() == 4);
+	assert(size_);
+
+	struct ChunkHeader {
+		char magic[4] = {'\0', '\0', '\0', '\0'};
+		uint32_t size = 0;
+	};
+	static_assert(sizeof(ChunkHeader) == 8, "header is packed");
+
+	if (file.size - offset < sizeof(ChunkHeader)) {
+		throw std::runtime_error("Failed to read chunk header ('" + magic + "') in '" + filename + "'.");
+	}
+	ChunkHeader header;
+	std::memcpy(&header, file.data + offset, sizeof(header));
+	offset += sizeof(header);
+
+	if (std::string(header.magic, 4) != magic) {
+		throw std::runtime_error("Unexpected magic number in chunk (expected '" + magic + "') in '" + filename + "'.");
+	}
+	if (header.size % element_size != 0) {
+		throw std::runtime_error("size of chunk '" + magic + "' not divisible by element size in '" + filename + "'.");
+	}
+	if (file.size - offset < header.size) {
+		throw std::runtime_error("Failed to read chunk data ('" + magic + "') in '" + filename + "'.");
+	}
+
+	char const *data = file.data + offset;
+	offset += header.size;
+	*size_ = header.size;
+	return data;
+}
+
+std::string_view ChunkReader::string(ChunkSpan< char > const &strings, uint32_t begin, uint32_t end) const {
+	if (!(begin <= end && end <= strings.size())) {
+		throw std::runtime_error("out-of-range string [" + std::to_string(begin) + "," + std::to_string(end) + ") in '" + filename + "'.");
+	}
+	return std::string_view(strings.data + begin, end - begin);
+}
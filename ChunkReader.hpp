@@ -0,0 +1,100 @@
+#pragma once
+
+/*
+ * Reads files in the read_chunk() format (see read_write_chunk.hpp) without copying them:
+ * the file is memory-mapped, and read() hands back spans of typed elements that point straight
+ * into the mapping (so they are only valid while the ChunkReader is alive).
+ *
+ * Every chunk's header and size are bounds-checked against the file. A chunk whose data isn't
+ * aligned for its element type (e.g. one following a "str0" chunk whose length isn't a multiple
+ * of four) is copied once into aligned storage owned by the reader instead.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+//read-only view of a whole file:
+struct MappedFile {
+	//note: will throw if the file can't be opened or mapped.
+	explicit MappedFile(std::string const &filename);
+	~MappedFile();
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	char const *data = nullptr;
+	size_t size = 0;
+
+#if defined(_WIN32)
+private:
+	void *handle = nullptr; //mapping object
+#endif
+};
+
+//elements of one chunk:
+template< typename T >
+struct ChunkSpan {
+	T const *data = nullptr;
+	size_t count = 0;
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T const *begin() const { return data; }
+	T const *end() const { return data + count; }
+	T const &operator[](size_t i) const { return data[i]; }
+};
+
+struct ChunkReader {
+	explicit ChunkReader(std::string const &filename);
+
+	//read the next chunk, which must have the given magic number:
+	// note: will throw if the header or data run past the end of the file or the size isn't a multiple of sizeof(T)
+	template< typename T >
+	ChunkSpan< T > read(std::string const &magic);
+
+	//text [begin,end) of a "str0"-style chunk:
+	// note: will throw if the range isn't inside the chunk
+	std::string_view string(ChunkSpan< char > const &strings, uint32_t begin, uint32_t end) const;
+
+	//true once every chunk in the file has been read:
+	bool at_end() const { return offset == file.size; }
+
+	std::string filename;
+	MappedFile file;
+
+private:
+	char const *read_raw(std::string const &magic, size_t element_size, size_t *size);
+
+	size_t offset = 0;
+	std::vector< std::unique_ptr< std::max_align_t[] > > aligned_copies;
+};
+
+template< typename T >
+ChunkSpan< T > ChunkReader::read(std::string const &magic) {
+	static_assert(std::is_trivially_copyable< T >::value, "chunks hold plain-old-data elements");
+	static_assert(alignof(T) <= alignof(std::max_align_t), "chunk elements are at most max_align_t aligned");
+
+	size_t size = 0;
+	char const *data = read_raw(magic, sizeof(T), &size);
+
+	ChunkSpan< T > ret;
+	ret.count = size / sizeof(T);
+	if (ret.count == 0) return ret;
+
+	if (reinterpret_cast< uintptr_t >(data) % alignof(T) != 0) {
+		//misaligned in the file, so keep an aligned copy:
+		size_t blocks = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		aligned_copies.emplace_back(new std::max_align_t[blocks]);
+		char *copy = reinterpret_cast< char * >(aligned_copies.back().get());
+		std::copy(data, data + size, copy);
+		data = copy;
+	}
+	ret.data = reinterpret_cast< T const * >(data);
+	return ret;
+}
@@ -1,5 +1,7 @@
 #include "ComicBookProgram.hpp"
 
+#include "Mesh.hpp"
+#include "UniformBlocks.hpp"
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
 #include "glm/ext.hpp"
@@ -18,22 +20,15 @@ Load< ComicBookProgram > lit_color_texture_program(LoadTagEarly, []() -> ComicBo
     lit_color_texture_program_pipeline.SPECULAR_BRIGHTNESS_vec3 = ret->SPECULAR_BRIGHTNESS_vec3;
     lit_color_texture_program_pipeline.SPECULAR_SHININESS_float = ret->SPECULAR_SHININESS_float;
 	lit_color_texture_program_pipeline.draw_frame = ret->draw_frame;
-    lit_color_texture_program_pipeline.set_uniforms = [ret]() {
-        glUniform1i(ret->LIGHT_TYPE_int, 1);
-        glUniform3fv(ret->LIGHT_DIRECTION_vec3, 1,
-                     glm::value_ptr(glm::normalize(glm::vec3(0.5f, 1.0f, -1.0f))));
-        glUniform3fv(ret->LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(0.6f, 0.65f, 0.7f)));
-        glUniform3fv(ret->AMBIENT_LIGHT_ENERGY_vec3, 1,
-                     glm::value_ptr(glm::vec3(0.35f, 0.3f, 0.25f)));
-    };
-
-	/* This will be used later if/when we build a light loop into the Scene:
-	lit_color_texture_program_pipeline.LIGHT_TYPE_int = ret->LIGHT_TYPE_int;
-	lit_color_texture_program_pipeline.LIGHT_LOCATION_vec3 = ret->LIGHT_LOCATION_vec3;
-	lit_color_texture_program_pipeline.LIGHT_DIRECTION_vec3 = ret->LIGHT_DIRECTION_vec3;
-	lit_color_texture_program_pipeline.LIGHT_ENERGY_vec3 = ret->LIGHT_ENERGY_vec3;
-	lit_color_texture_program_pipeline.LIGHT_CUTOFF_float = ret->LIGHT_CUTOFF_float;
-	*/
+
+	//this program's light rig (both variants read it through their "Light" block); set once here,
+	// since nothing changes it afterwards:
+	UniformBlocks::Light light;
+	light.LIGHT_TYPE = 1;
+	light.LIGHT_DIRECTION = glm::normalize(glm::vec3(0.5f, 1.0f, -1.0f));
+	light.LIGHT_ENERGY = glm::vec3(0.6f, 0.65f, 0.7f);
+	light.AMBIENT_LIGHT_ENERGY = glm::vec3(0.35f, 0.3f, 0.25f);
+	UniformBlocks::set_light(UniformBlocks::LitLightBinding, light);
 
 	//make a 1-pixel white texture to bind by default:
 	GLuint tex;
@@ -55,15 +50,34 @@ Load< ComicBookProgram > lit_color_texture_program(LoadTagEarly, []() -> ComicBo
 	return ret;
 });
 
-ComicBookProgram::ComicBookProgram() {
+Load< ComicBookProgram > lit_color_texture_program_instanced(LoadTagEarly, []() -> ComicBookProgram const * {
+	ComicBookProgram *ret = new ComicBookProgram(true);
+
+	//----- fill in the pipeline template's instanced variant -----
+	lit_color_texture_program_pipeline.instanced.program = ret->program;
+	lit_color_texture_program_pipeline.instanced.draw_frame = ret->draw_frame;
+
+	return ret;
+});
+
+ComicBookProgram::ComicBookProgram(bool instanced) {
+	//the instanced variant takes per-instance transforms / specular info as attributes (see MeshBuffer::Instance);
+	//camera, frame and light values come from the shared uniform blocks (see UniformBlocks.hpp):
+	std::string header = std::string(instanced ? "#version 330\n#define INSTANCED\n" : "#version 330\n") + UniformBlocks::GLSL;
+
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
 	program = gl_compile_program(
 		//vertex shader:
-		"#version 330\n"
+		header + MeshBuffer::BarycentricVertexGLSL +
+		"#ifdef INSTANCED\n"
+		"in mat4x3 INSTANCE_TO_WORLD;\n"
+		"in vec4 INSTANCE_SPECULAR;\n"
+		"flat out vec4 instanceSpecular;\n"
+		"#else\n"
 		"uniform mat4 OBJECT_TO_CLIP;\n"
 		"uniform mat4x3 OBJECT_TO_LIGHT;\n"
 		"uniform mat3 NORMAL_TO_LIGHT;\n"
-        "uniform sampler2D DEPTH;\n"
+		"#endif\n"
         "uniform sampler2D DOT;\n"
         "uniform sampler2D SHADOW_DEPTH;\n"
         "in vec4 Position;\n"
@@ -75,30 +89,35 @@ ComicBookProgram::ComicBookProgram() {
 		"out vec4 color;\n"
 		"out vec2 texCoord;\n"
 		"void main() {\n"
+		"#ifdef INSTANCED\n"
+		"	mat4 OBJECT_TO_CLIP = WORLD_TO_CLIP * mat4(INSTANCE_TO_WORLD);\n"
+		"	mat4x3 OBJECT_TO_LIGHT = WORLD_TO_LIGHT * mat4(INSTANCE_TO_WORLD);\n"
+		"	mat3 NORMAL_TO_LIGHT = inverse(transpose(mat3(OBJECT_TO_LIGHT)));\n"
+		"	instanceSpecular = INSTANCE_SPECULAR;\n"
+		"#endif\n"
 		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
 		"	position = OBJECT_TO_LIGHT * Position;\n"
 		"	normal = NORMAL_TO_LIGHT * Normal;\n"
 		"	color = Color;\n"
 		"	texCoord = TexCoord;\n"
+		"	barycentric = Barycentric;\n"
 		"}\n"
 	,
 		//fragment shader:
-		"#version 330\n"
+		header + MeshBuffer::BarycentricFragmentGLSL +
         "#define PI 3.1415926538\n"
-        "uniform mat4 OBJECT_TO_CLIP;\n"
         "uniform sampler2D TEX;\n"
         "uniform sampler2D SHADOW_DEPTH;\n"
-        "uniform int LIGHT_TYPE;\n"
-		"uniform vec3 LIGHT_LOCATION;\n"
-		"uniform vec3 LIGHT_DIRECTION;\n"
-		"uniform vec3 LIGHT_ENERGY;\n"
-        "uniform vec3 AMBIENT_LIGHT_ENERGY;\n"
+        "#ifdef INSTANCED\n"
+        "flat in vec4 instanceSpecular;\n"
+        "#define SPECULAR_SHININESS instanceSpecular.a\n"
+        "#define SPECULAR_BRIGHTNESS instanceSpecular.rgb\n"
+        "#else\n"
         "uniform float SPECULAR_SHININESS;\n"
         "uniform vec3 SPECULAR_BRIGHTNESS;\n"
-        "uniform float LIGHT_CUTOFF;\n"
-        "uniform sampler2D DEPTH;\n"
+        "#endif\n"
+        "uniform sampler2D EDGES; //outline mask (see EdgeDetectProgram)\n"
         "uniform sampler2D DOT;\n"
-        "uniform vec4 WINDOW_DIMENSIONS;\n"
         "uniform bool COMIC_BOOK;"
         "in vec3 position;\n"
 		"in vec3 normal;\n"
@@ -107,21 +126,9 @@ ComicBookProgram::ComicBookProgram() {
 		"out vec4 fragColor;\n"
 		"uniform bool wireframe;\n"
         "// Code adapted from https://github.com/aehmttw/Machimania/blob/master/resources/shaders/main.frag\n"
-        "mat3 toMat3(mat4 matrix) {\n"
-        "    return mat3(matrix[0].xyz, matrix[1].xyz, matrix[2].xyz);\n"
-        "}\n"
         "float det(mat2 matrix) {\n"
         "    return matrix[0].x * matrix[1].y - matrix[0].y * matrix[1].x;\n"
         "}\n"
-        "float tex(float x, float y) {\n"
-        "    return pow(1.0f - texture(DEPTH, vec2(x / WINDOW_DIMENSIONS.x, y / WINDOW_DIMENSIONS.y)).x, 0.1);\n"
-        "}\n"
-        "float outlineWeight(float x, float y) {\n"
-        "    float a = 0.001;\n"
-        "    float b = 0.002;\n"
-        "    float v = (abs(tex(x - 1, y) - tex(x, y)) + abs(tex(x, y - 1) - tex(x, y)));\n"
-        "    return max(0.0, min(1.0, (v - a) / (b - a)));\n"
-        "}\n"
         "float pixelShade(float x, float y, float shade) {\n"
         "   float bsize = 0.25;\n"
         "   int bracket = int(shade / bsize);\n"
@@ -149,6 +156,7 @@ ComicBookProgram::ComicBookProgram() {
         "   return int(texture(SHADOW_DEPTH, vec2(position.x + 1.0, position.y + 1.0) / 2.0).x < -0.001 + (position.z + 1.0) / 2.0);\n"
         "}\n"
 		"void main() {\n"
+		"	if (wireframe && offWireframe()) discard; //(wireframe drawables keep just their triangles' edges)\n"
 		"	vec3 n = normalize(normal);\n"
 		"	vec3 e;\n"
 		"	if (LIGHT_TYPE == 0) { //point light \n"
@@ -174,7 +182,7 @@ ComicBookProgram::ComicBookProgram() {
 		"	} else { //(LIGHT_TYPE == 3) //directional light \n"
 		"		e = max(0.0, dot(n,-LIGHT_DIRECTION)) * LIGHT_ENERGY;\n"
 		"	}\n"
-        "   vec3 cam = normalize((inverse(toMat3(OBJECT_TO_CLIP)) * vec3(0, 0, 1)).xyz);\n"
+        "   vec3 cam = VIEW_DIRECTION; //(the same for every object, however it is drawn)\n"
         "   vec3 h = normalize(cam + normalize(-LIGHT_DIRECTION));\n"
         "   float specular = pow(max(dot(n, h), 0), SPECULAR_SHININESS);\n"
         "   e += specular * SPECULAR_BRIGHTNESS;\n"
@@ -186,13 +194,7 @@ ComicBookProgram::ComicBookProgram() {
 		"		fragColor = vec4(e*albedo.rgb, 1.0);\n"
 		"	}\n"
         "    \n"
-        "   float weight = 0; \n"
-        "   float kernel[] = float[25](0.0, 0.1, 0.2, 0.1, 0.0, 0.1, 0.4, 0.6, 0.4, 0.1, 0.2, 0.6, 1.0, 0.6, 0.2, 0.1, 0.4, 0.6, 0.4, 0.1, 0.0, 0.1, 0.2, 0.1, 0.0);\n"
-        "   for (int i = 0; i < 5; i++) {\n"
-        "       for (int j = 0; j < 5; j++) {\n"
-        "           weight += kernel[i * 5 + j] * outlineWeight(gl_FragCoord.x + i - 2, gl_FragCoord.y + j - 2);\n"
-        "       }\n"
-        "   }\n"
+        "   float weight = texelFetch(EDGES, ivec2(gl_FragCoord.xy), 0).r;\n"
         "   fragColor.xyz *= 1.0f - max(0.0f, weight);\n"
         "   float scale = max(WINDOW_DIMENSIONS.z / 1280.0, WINDOW_DIMENSIONS.w / 720.0);"
         "   fragColor.xyz = pixelColor(gl_FragCoord.xy / scale, fragColor.xyz);\n"
@@ -212,21 +214,16 @@ ComicBookProgram::ComicBookProgram() {
 	OBJECT_TO_LIGHT_mat4x3 = glGetUniformLocation(program, "OBJECT_TO_LIGHT");
 	NORMAL_TO_LIGHT_mat3 = glGetUniformLocation(program, "NORMAL_TO_LIGHT");
 
-	LIGHT_TYPE_int = glGetUniformLocation(program, "LIGHT_TYPE");
-	LIGHT_LOCATION_vec3 = glGetUniformLocation(program, "LIGHT_LOCATION");
-	LIGHT_DIRECTION_vec3 = glGetUniformLocation(program, "LIGHT_DIRECTION");
-	LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "LIGHT_ENERGY");
-    AMBIENT_LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "AMBIENT_LIGHT_ENERGY");
-    LIGHT_CUTOFF_float = glGetUniformLocation(program, "LIGHT_CUTOFF");
     SPECULAR_BRIGHTNESS_vec3 = glGetUniformLocation(program, "SPECULAR_BRIGHTNESS");
     SPECULAR_SHININESS_float = glGetUniformLocation(program, "SPECULAR_SHININESS");
 
-    WINDOW_DIMENSIONS = glGetUniformLocation(program, "WINDOW_DIMENSIONS");
-
 	draw_frame = glGetUniformLocation(program,"wireframe");
 
+	//point the uniform blocks at the shared buffers:
+	UniformBlocks::bind(program, UniformBlocks::LitLightBinding);
+
     GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
-    GLuint DEPTH_sampler2D = glGetUniformLocation(program, "DEPTH");
+    GLuint EDGES_sampler2D = glGetUniformLocation(program, "EDGES");
     GLuint DOT_sampler2D = glGetUniformLocation(program, "DOT");
     GLuint SHADOW_DEPTH_sampler2D = glGetUniformLocation(program, "SHADOW_DEPTH");
 
@@ -234,7 +231,7 @@ ComicBookProgram::ComicBookProgram() {
 	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
 
 	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
-    glUniform1i(DEPTH_sampler2D, 1); //set DEPTH to sample from GL_TEXTURE1
+    glUniform1i(EDGES_sampler2D, 1); //set EDGES to sample from GL_TEXTURE1
     glUniform1i(DOT_sampler2D, 2); //set DEPTH to sample from GL_TEXTURE2
     glUniform1i(SHADOW_DEPTH_sampler2D, 3); //set SHADOW_DEPTH to sample from GL_TEXTURE3
 
@@ -6,7 +6,7 @@
 
 //Comic book-like shader, inspired by this: https://github.com/jingtaoh/Ben-Day-Dots-Shading
 struct ComicBookProgram {
-	ComicBookProgram();
+	ComicBookProgram(bool instanced = false);
 	~ComicBookProgram();
 
 	GLuint program = 0;
@@ -21,16 +21,7 @@ struct ComicBookProgram {
 	GLuint OBJECT_TO_CLIP_mat4 = -1U;
 	GLuint OBJECT_TO_LIGHT_mat4x3 = -1U;
 	GLuint NORMAL_TO_LIGHT_mat3 = -1U;
-
-	//lighting:
-	GLuint LIGHT_TYPE_int = -1U;
-	GLuint LIGHT_LOCATION_vec3 = -1U;
-	GLuint LIGHT_DIRECTION_vec3 = -1U;
-	GLuint LIGHT_ENERGY_vec3 = -1U;
-    GLuint AMBIENT_LIGHT_ENERGY_vec3 = -1U;
-    GLuint LIGHT_CUTOFF_float = -1U;
-
-    GLuint WINDOW_DIMENSIONS = -1U;
+	//(camera, window and lighting values are in the shared uniform blocks; see UniformBlocks.hpp)
 
     // How bright specular reflections (mirror effect of light) should be
     GLuint SPECULAR_BRIGHTNESS_vec3 = -1U;
@@ -44,9 +35,14 @@ struct ComicBookProgram {
 	
 	//Textures:
 	//TEXTURE0 - texture that is accessed by TexCoord
+	//TEXTURE1 - EDGES: outline mask, one texel per pixel (written by EdgeDetectProgram each frame)
+	//TEXTURE2 - DOT: halftone dot pattern
+	//TEXTURE3 - SHADOW_DEPTH: shadow map
 };
 
 extern Load< ComicBookProgram > lit_color_texture_program;
+//(same program compiled with INSTANCED; fills in lit_color_texture_program_pipeline.instanced)
+extern Load< ComicBookProgram > lit_color_texture_program_instanced;
 
 //For convenient scene-graph setup, copy this object:
 // NOTE: by default, has texture bound to 1-pixel white texture -- so it's okay to use with vertex-color-only meshes.
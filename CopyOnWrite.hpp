@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * A value that copies share until one of them is written to:
+ *  - reading (*x, x->member) never copies
+ *  - x.write() returns a mutable reference, first cloning the value if any other copy shares it
+ *
+ * Used by Scene::Drawable so that cloning a Scene doesn't duplicate every drawable's pipeline.
+ * NOTE: sharing is tracked with shared_ptr::use_count, so don't write() one copy while another
+ *  thread is copying or writing another copy of the same value.
+ */
+
+#include <memory>
+
+template< typename T >
+struct CopyOnWrite {
+	CopyOnWrite() : value(std::make_shared< T >()) { }
+	CopyOnWrite(T const &value_) : value(std::make_shared< T >(value_)) { }
+
+	CopyOnWrite &operator=(T const &value_) {
+		value = std::make_shared< T >(value_);
+		return *this;
+	}
+
+	T const &operator*() const { return *value; }
+	T const *operator->() const { return value.get(); }
+
+	T &write() {
+		if (value.use_count() > 1) value = std::make_shared< T >(*value);
+		return *value;
+	}
+
+	//is the value currently shared with another copy?
+	bool shared() const { return value.use_count() > 1; }
+
+private:
+	std::shared_ptr< T > value;
+};
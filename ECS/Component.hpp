@@ -1,56 +1,205 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdlib>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include <functional>
 #include "Entity.hpp"
+#include "SparseSet.hpp"
+#include "ThreadPool.hpp"
 
 template<typename T>
 struct Component {
-    static std::unordered_map<uint32_t, T> &get_map() {
-        static std::unordered_map<uint32_t, T> map;
-        return map;
+    /*
+     * Packed storage of every T, keyed by entity id (see SparseSet.hpp)
+     */
+    static SparseSet<T> &get_storage() {
+        static SparseSet<T> storage;
+        return storage;
     };
+
+    /*
+     * Adds/removes made while a system is running, buffered per thread so par_system
+     * workers never contend on them. Every thread's buffers are merged by flush().
+     */
+    struct DeferredBuffers {
+        /* added to in Entity::remove_component<T>() */
+        std::vector<uint32_t> to_delete;
+        /* kept as a map so references returned by Entity::add_component<T>() during a system stay valid */
+        std::unordered_map<uint32_t, T> to_add;
+        
+        DeferredBuffers() {
+            std::lock_guard<std::mutex> lock(get_registry_mutex());
+            get_registry().push_back(this);
+        }
+        
+        ~DeferredBuffers() {
+            std::lock_guard<std::mutex> lock(get_registry_mutex());
+            auto &registry = get_registry();
+            registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+        }
+    };
+    
+    static DeferredBuffers &get_deferred() {
+        thread_local DeferredBuffers buffers;
+        return buffers;
+    }
     
-    /* added to in Entity::remove_component<T>() */
-    // inline static std::vector<uint32_t> to_delete;
-    // inline static std::unordered_map<uint32_t, T> to_add;
-    // inline static bool system_running = false;
     static std::vector<uint32_t> &get_to_delete() {
-        static std::vector<uint32_t> to_delete;
-        return to_delete;
+        return get_deferred().to_delete;
     }
 
     static std::unordered_map<uint32_t, T> &get_to_add() {
-        static std::unordered_map<uint32_t, T> to_add;
-        return to_add;
+        return get_deferred().to_add;
     }
 
     static bool &get_system_running() {
         static bool system_running;
         return system_running;
     }
+
+    /*
+     * Remove the component owned by id, deferring the removal if a system is running
+     * (erasing from the packed storage mid-iteration would move elements under the loop).
+     */
+    static void remove(uint32_t id) {
+        if (get_system_running()) {
+            get_to_add().erase(id);
+            get_to_delete().push_back(id);
+        } else {
+            erase_now(id);
+        }
+    }
+    
+    /*
+     * Change tracking: stamp id's T as modified (systems can't see writes on their own).
+     * Safe inside system / par_system callbacks for the component being visited.
+     */
+    static void mark_changed(uint32_t id) {
+        get_storage().mark_changed(id);
+    }
+    
+    /* Has id's T been added or marked changed after tick `since`? */
+    static bool changed_since(uint32_t id, uint64_t since) {
+        return get_storage().changed_tick(id) > since;
+    }
+    
+    /*
+     * Call f(id) for each T removed after tick `since`. Only the most recent RemovedHistory
+     * removals are kept, so consumers should poll at least that often.
+     */
+    static constexpr size_t RemovedHistory = 4096;
+    
+    template<typename F>
+    static void each_removed_since(uint64_t since, F &&f) {
+        for (auto const &[id, tick]: get_removed()) {
+            if (tick > since) f(id);
+        }
+    }
+
+    /*
+     * Marks a system over T as running for the lifetime of the scope, so adds/removes of T
+     * are deferred. Scopes nest: the deferred changes are applied when the outermost one ends.
+     */
+    struct SystemScope {
+        SystemScope() : was_running(get_system_running()) {
+            get_system_running() = true;
+            Entity::begin_system();
+        }
+        
+        ~SystemScope() {
+            if (!was_running) {
+                get_system_running() = false;
+                flush();
+            }
+            Entity::end_system();
+        }
+        
+        SystemScope(SystemScope const &) = delete;
+        SystemScope &operator=(SystemScope const &) = delete;
+    
+    private:
+        bool was_running;
+    };
     
     /*
      * Run the given function on all components in arbitrary order.
      * Thanks to the addition of Component<T>::to_delete and Component<T>::system_running
      * and revision of Entity code, Entity::remove_component<T>() should be fine to be called in the
      * lambda passed to Component<T>::system(f) so long as no component is removed more than once.
+     * f is taken as a template parameter (rather than a std::function) so the per-component
+     * call can be inlined into the loop.
      */
-    static void system(const std::function<void(T &)> &f) {
-        get_system_running() = true;
-        for (auto &[_, component]: get_map()) {
+    template<typename F>
+    static void system(F &&f) {
+        SystemScope scope;
+        for (T &component: get_storage()) {
             f(component);
         }
-        get_system_running() = false;
-        for (uint32_t id: get_to_delete()) {
-            get_map().erase(id);
+    }
+    
+    /*
+     * Like system(f), but runs f on chunks of (at most) grain components in parallel on
+     * ThreadPool::get(). Call it from the main thread, with no other system over T running.
+     * f may add/remove T components (deferred as usual, into per-thread buffers merged
+     * afterwards; if two threads add the same id the first buffer merged wins), but must not
+     * create/destroy entities or add/remove components of other types, and must only touch
+     * state that no other invocation of f touches. Meant for pure-CPU per-component work.
+     */
+    template<typename F>
+    static void par_system(F &&f, size_t grain = 256) {
+        SystemScope scope;
+        SparseSet<T> &storage = get_storage();
+        T *components = storage.data();
+        ThreadPool::get().parallel_for(storage.size(), grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                f(components[i]);
+            }
+        });
+    }
+
+private:
+    /* (id, tick) of recent removals, oldest first */
+    static std::vector<std::pair<uint32_t, uint64_t>> &get_removed() {
+        static std::vector<std::pair<uint32_t, uint64_t>> removed;
+        return removed;
+    }
+    
+    static void erase_now(uint32_t id) {
+        if (!get_storage().erase(id)) return;
+        auto &removed = get_removed();
+        if (removed.size() >= 2 * RemovedHistory) {
+            removed.erase(removed.begin(), removed.end() - RemovedHistory);
+        }
+        removed.emplace_back(id, next_change_tick());
+    }
+    
+    static std::vector<DeferredBuffers *> &get_registry() {
+        static std::vector<DeferredBuffers *> registry;
+        return registry;
+    }
+    
+    static std::mutex &get_registry_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+    
+    /* apply the adds/removes deferred (on any thread) while a system was running */
+    static void flush() {
+        std::lock_guard<std::mutex> lock(get_registry_mutex());
+        for (DeferredBuffers *buffers: get_registry()) {
+            for (uint32_t id: buffers->to_delete) {
+                erase_now(id);
+            }
+            buffers->to_delete.clear();
         }
-        get_to_delete().clear();
-        for (auto [id, component]: get_to_add()) {
-            get_map().emplace(id, component);
+        for (DeferredBuffers *buffers: get_registry()) {
+            for (auto &[id, component]: buffers->to_add) {
+                get_storage().emplace(id, std::move(component));
+            }
+            buffers->to_add.clear();
         }
-        get_to_add().clear();
     }
 };
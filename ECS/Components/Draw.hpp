@@ -6,6 +6,6 @@
  * A component marking things to draw *after* all the Scene::Drawables.
  * Note that confusingly, Scene::Drawables do not have this component.
  */
-struct Draw : HandlerComponent<Draw, void> {
-    using HandlerComponent<Draw, void>::HandlerComponent;
+struct Draw : InplaceHandlerComponent<Draw, void> {
+    using InplaceHandlerComponent<Draw, void>::InplaceHandlerComponent;
 };
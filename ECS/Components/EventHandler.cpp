@@ -1,10 +1,94 @@
+//
+// Created by Russell Emerine on 11/20/23.
+//
+
+#include "Draw.hpp"
+#include <algorithm>
 #include <functional>
 #include "EventHandler.hpp"
 
+namespace {
+/*
+ * Handler ids bucketed by (event type, key), each bucket sorted by descending priority.
+ * Rebuilt only when the set of EventHandlers changes.
+ */
+struct DispatchIndex {
+    uint64_t version = ~uint64_t(0);
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    std::vector<uint32_t> const empty;
+
+    static uint64_t bucket_key(uint32_t type, SDL_Keycode key) {
+        return (uint64_t(type) << 32) | uint32_t(key);
+    }
+
+    std::vector<uint32_t> const &bucket(uint32_t type, SDL_Keycode key) const {
+        auto f = buckets.find(bucket_key(type, key));
+        return f == buckets.end() ? empty : f->second;
+    }
+
+    void rebuild() {
+        SparseSet<EventHandler> &storage = EventHandler::get_storage();
+        buckets.clear();
+        std::vector<uint32_t> const &ids = storage.ids();
+        for (size_t i = 0; i < ids.size(); ++i) {
+            EventFilter const &filter = storage.data()[i].filter;
+            buckets[bucket_key(filter.type, filter.key)].emplace_back(ids[i]);
+        }
+        for (auto &[_, bucket]: buckets) {
+            std::stable_sort(bucket.begin(), bucket.end(), [&](uint32_t a, uint32_t b) {
+                return storage.find(a)->filter.priority > storage.find(b)->filter.priority;
+            });
+        }
+        version = storage.version();
+    }
+};
+
+bool is_key_event(SDL_Event const &evt) {
+    return evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP;
+}
+}
+
 bool EventHandler::handle_event_all(const SDL_Event &evt, const glm::uvec2 &window_size) {
-    bool handled;
-    EventHandler::system([&](EventHandler &h) {
-        handled |= h.handle(evt, window_size);
-    });
-    return handled;
+    static DispatchIndex index;
+    if (index.version != get_storage().version()) index.rebuild();
+
+    /* handlers added/removed by a handler take effect (and reach the index) after this event */
+    SystemScope scope;
+
+    /* the buckets that can match this event, merged by priority */
+    std::vector<uint32_t> const *buckets[3] = {
+            &index.bucket(EventFilter::AnyType, EventFilter::AnyKey),
+            &index.bucket(evt.type, EventFilter::AnyKey),
+            is_key_event(evt) ? &index.bucket(evt.type, evt.key.keysym.sym) : &index.empty,
+    };
+    size_t next[3] = {0, 0, 0};
+    while (true) {
+        EventHandler *best = nullptr;
+        size_t best_bucket = 0;
+        for (size_t b = 0; b < 3; ++b) {
+            if (next[b] >= buckets[b]->size()) continue;
+            EventHandler *h = get_storage().find((*buckets[b])[next[b]]);
+            if (!best || h->filter.priority > best->filter.priority) {
+                best = h;
+                best_bucket = b;
+            }
+        }
+        if (!best) return false;
+        next[best_bucket] += 1;
+        if (best->handle(evt, window_size)) return true;
+    }
+}
+
+void EventBatch::push(SDL_Event const &evt) {
+    if (evt.type == SDL_MOUSEMOTION && !events.empty() && events.back().type == SDL_MOUSEMOTION) {
+        SDL_MouseMotionEvent &merged = events.back().motion;
+        merged.xrel += evt.motion.xrel;
+        merged.yrel += evt.motion.yrel;
+        merged.x = evt.motion.x;
+        merged.y = evt.motion.y;
+        merged.state = evt.motion.state;
+        merged.timestamp = evt.motion.timestamp;
+        return;
+    }
+    events.emplace_back(evt);
 }
@@ -8,15 +8,55 @@
 
 #include <cstdlib>
 #include <unordered_map>
+#include <vector>
 
 #include <SDL.h>
 #include <glm/glm.hpp>
 #include "../HandlerComponent.hpp"
 
+/*
+ * Which events an EventHandler wants, and in what order handlers get them.
+ * A handler only sees events of its type (and, for key events, its key);
+ * AnyType / AnyKey match everything.
+ */
+struct EventFilter {
+    static constexpr uint32_t AnyType = 0;
+    static constexpr SDL_Keycode AnyKey = 0;
+
+    uint32_t type = AnyType;
+    SDL_Keycode key = AnyKey;
+    /* higher priorities see events first; a handler returning true stops the event there */
+    int priority = 0;
+};
+
 /* A struct to handle SDL input events */
-struct EventHandler : HandlerComponent<EventHandler, bool, SDL_Event const &, glm::uvec2 const &> {
-    using HandlerComponent<EventHandler, bool, SDL_Event const &, glm::uvec2 const &>::HandlerComponent;
-    
-    /* Handle all events in no particular order. Returns true if any handler handles the event. */
+struct EventHandler : InplaceHandlerComponent<EventHandler, bool, SDL_Event const &, glm::uvec2 const &> {
+    using InplaceHandlerComponent<EventHandler, bool, SDL_Event const &, glm::uvec2 const &>::InplaceHandlerComponent;
+
+    template<typename F>
+    EventHandler(EventFilter filter, F &&f)
+            : InplaceHandlerComponent<EventHandler, bool, SDL_Event const &, glm::uvec2 const &>(std::forward<F>(f)),
+              filter(filter) {}
+
+    EventFilter filter;
+
+    /*
+     * Offer the event to the handlers whose filter matches it, highest priority first,
+     * until one of them returns true. Returns true if any handler handled the event.
+     * Handlers are indexed by (type, key), so an event only costs the handlers interested in it.
+     */
     static bool handle_event_all(SDL_Event const &evt, glm::uvec2 const &window_size);
 };
+
+/*
+ * The events of one frame. Runs of consecutive mouse motion events are merged into one
+ * (relative motion summed, absolute position/buttons from the latest), so a flood of
+ * motion costs one dispatch.
+ */
+struct EventBatch {
+    std::vector<SDL_Event> events;
+
+    void push(SDL_Event const &evt);
+
+    void clear() { events.clear(); }
+};
@@ -11,6 +11,6 @@ enum struct Command {
     Cook
 };
 
-struct TerminalCommandHandler : HandlerComponent<TerminalCommandHandler, void, Command> {
-    using HandlerComponent<TerminalCommandHandler, void, Command>::HandlerComponent;
+struct TerminalCommandHandler : InplaceHandlerComponent<TerminalCommandHandler, void, Command> {
+    using InplaceHandlerComponent<TerminalCommandHandler, void, Command>::InplaceHandlerComponent;
 };
@@ -7,15 +7,92 @@
 
 #include "Entity.hpp"
 
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+/* per-id generation counters; an id is live iff it isn't in free_ids or pending_free_ids */
+std::vector<uint32_t> &generations() {
+    static std::vector<uint32_t> generations;
+    return generations;
+}
+
+/* ids ready to be handed out again */
+std::vector<uint32_t> &free_ids() {
+    static std::vector<uint32_t> free_ids;
+    return free_ids;
+}
+
+/* ids released while a system was running */
+std::vector<uint32_t> &pending_free_ids() {
+    static std::vector<uint32_t> pending_free_ids;
+    return pending_free_ids;
+}
+
+uint32_t &systems_running() {
+    static uint32_t systems_running = 0;
+    return systems_running;
+}
+
+/* component_type() -> T::remove */
+std::vector<void (*)(uint32_t)> &removers() {
+    static std::vector<void (*)(uint32_t)> removers;
+    return removers;
+}
+}
+
 Entity::Entity() {
-    /* create unique id for entity lookup */
-    static uint32_t unique_id = 0;
-    id = unique_id;
-    unique_id++;
+    /* reuse the most recently freed id, so storage indexed by id stays compact */
+    if (!free_ids().empty()) {
+        id = free_ids().back();
+        free_ids().pop_back();
+    } else {
+        id = uint32_t(generations().size());
+        generations().emplace_back(0);
+    }
+    generation = generations()[id];
 }
 
 Entity::~Entity() {
-    for (auto &[_, f]: to_delete) {
-        f();
+    /* walk the set bits of the mask instead of a map of per-component cleanup closures */
+    uint64_t mask = component_mask;
+    for (uint32_t type = 0; mask; ++type, mask >>= 1) {
+        if (mask & 1) removers()[type](id);
+    }
+
+    generations()[id] += 1;
+    if (systems_running()) {
+        pending_free_ids().emplace_back(id);
+    } else {
+        free_ids().emplace_back(id);
+    }
+}
+
+bool Entity::is_alive(Handle handle) {
+    return handle.id < generations().size() && generations()[handle.id] == handle.generation;
+}
+
+void Entity::begin_system() {
+    systems_running() += 1;
+}
+
+void Entity::end_system() {
+    systems_running() -= 1;
+    if (systems_running() == 0) {
+        free_ids().insert(free_ids().end(), pending_free_ids().begin(), pending_free_ids().end());
+        pending_free_ids().clear();
+    }
+}
+
+uint32_t Entity::register_component_type(void (*remove)(uint32_t)) {
+    /* first use of a component type may happen on a par_system worker */
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (removers().size() >= MaxComponentTypes) {
+        throw std::runtime_error("More than " + std::to_string(MaxComponentTypes) + " component types registered.");
     }
+    removers().emplace_back(remove);
+    return uint32_t(removers().size() - 1);
 }
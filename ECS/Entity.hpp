@@ -5,70 +5,122 @@
 #pragma once
 
 #include <cstdlib>
+#include <cstdint>
 #include <unordered_map>
-#include <typeindex>
 #include <iostream>
 #include <functional>
 
 struct Entity {
     Entity();
-    
+
     /*
      * Destruct the entity by removing all components that haven't yet been removed
      */
     ~Entity();
-    
+
+    /*
+     * Components refer back to their entity by id (and handlers usually capture `this`),
+     * so entities stay where they were constructed.
+     */
+    Entity(Entity const &) = delete;
+    Entity &operator=(Entity const &) = delete;
+
     /*
-     * Unique identity for querying and deleting entities, generated uniquely in the constructor
+     * Index for querying and deleting entities, assigned in the constructor.
+     * Ids of destroyed entities are recycled (so component storage stays dense);
+     * use handle() to refer to an entity that might be destroyed.
      */
     uint32_t id;
-    
+
+    /*
+     * Number of times id had been recycled when this entity took it
+     */
+    uint32_t generation;
+
+    /*
+     * A reference to an entity that can be checked for staleness with Entity::is_alive
+     */
+    struct Handle {
+        uint32_t id = ~0u;
+        uint32_t generation = 0;
+
+        bool operator==(Handle const &other) const { return id == other.id && generation == other.generation; }
+
+        bool operator!=(Handle const &other) const { return !(*this == other); }
+    };
+
+    Handle handle() const { return Handle{id, generation}; }
+
+    /*
+     * Is the entity the handle was taken from still alive?
+     */
+    static bool is_alive(Handle handle);
+
     /*
      * Associate a component with this entity, update map of entities with component T
      */
     template<typename T, typename... Args>
     T &add_component(Args &&... args) {
-        to_delete[std::type_index(typeid(T))] = [this]() {
-            std::unordered_map<uint32_t, T> &entity_to_component = T::get_map();
-            entity_to_component.erase(id);
-        };
-        
+        component_mask |= uint64_t(1) << component_type<T>();
+
         if (T::get_system_running()) {
             return T::get_to_add().emplace(id, T(args...)).first->second;
         } else {
-            std::unordered_map<uint32_t, T> &entity_to_component = T::get_map();
-            return entity_to_component.emplace(id, T(args...)).first->second;
+            return *T::get_storage().emplace(id, T(args...)).first;
         }
     }
-    
+
     /*
      * Look up a component associated with this entity
+     * (the pointer is invalidated by the next add/remove of a T outside a system)
      */
     template<typename T>
     T *get_component() {
-        std::unordered_map<uint32_t, T> &entity_to_component = T::get_map();
-        auto f = entity_to_component.find(id);
-        if (f == entity_to_component.end()) return nullptr;
-        else return &f->second;
+        return T::get_storage().find(id);
     }
-    
+
     /*
      * Remove a component associated with this entity (if the entity has the component)
      */
     template<typename T>
     void remove_component() {
-        to_delete.erase(std::type_index(typeid(T)));
-        if (T::get_system_running()) {
-            T::get_to_delete().push_back(id);
-        } else {
-            std::unordered_map<uint32_t, T> &entity_to_component = T::get_map();
-            entity_to_component.erase(id);
-        }
+        component_mask &= ~(uint64_t(1) << component_type<T>());
+        T::remove(id);
+    }
+
+    /*
+     * Does this entity have (or have a pending add of) a component of type T?
+     */
+    template<typename T>
+    bool has_component() const {
+        return (component_mask >> component_type<T>()) & 1;
+    }
+
+    /*
+     * Small dense id for each component type, assigned on first use.
+     * Also registers T::remove so ~Entity can clean up by id.
+     */
+    static constexpr uint32_t MaxComponentTypes = 64;
+
+    template<typename T>
+    static uint32_t component_type() {
+        static uint32_t const type = register_component_type([](uint32_t id) { T::remove(id); });
+        return type;
     }
 
+    /*
+     * Called by Component<T>::SystemScope: while any system is running, ids of destroyed
+     * entities are not recycled, since their components may still be pending deletion.
+     */
+    static void begin_system();
+
+    static void end_system();
+
 private:
+    static uint32_t register_component_type(void (*remove)(uint32_t id));
+
     /*
-     * Keep track of what components to delete upon destruction
+     * Bit i is set if this entity has a component with component_type() == i
      */
-    std::unordered_map<std::type_index, std::function<void()>> to_delete;
+    uint64_t component_mask = 0;
 };
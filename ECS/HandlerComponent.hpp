@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Component.hpp"
+#include "InplaceFunction.hpp"
 
 /*
  * It seems that many components consist mainly of a single callback.
@@ -15,11 +16,18 @@
  * so most inheriting structs will need to make their own system methods.
  * However, HandlerComponent does have `handle_all`, which runs all handlers on
  * the same input and throws away the output.
+ *
+ * BasicHandlerComponent is the shared implementation, parameterized on how the
+ * callback is stored. HandlerComponent keeps it in a std::function (any capture
+ * size, may allocate); InplaceHandlerComponent keeps it in an InplaceFunction
+ * (captures must fit in InplaceFunction's buffer, never allocates, cheaper to call).
+ * Prefer InplaceHandlerComponent for handlers that run every frame.
  */
-template<typename T, typename R, typename... Args>
-struct HandlerComponent : Component<T> {
+template<typename T, typename Callback, typename R, typename... Args>
+struct BasicHandlerComponent : Component<T> {
     /* Create a handler_callback component with a callback */
-    explicit HandlerComponent(const std::function<R(Args...)> &f) : handler_callback(f) {}
+    template<typename F, typename = std::enable_if_t<!std::is_base_of_v<BasicHandlerComponent, std::decay_t<F>>>>
+    explicit BasicHandlerComponent(F &&f) : handler_callback(std::forward<F>(f)) {}
     
     /* Invoke the callback */
     R handle(Args... args) {
@@ -38,5 +46,15 @@ private:
      * (This was at first named `handler`, but it turns out that `handler`
      * is a useful variable name, and that caused shadowing conflicts.)
      */
-    std::function<R(Args...)> handler_callback;
+    Callback handler_callback;
+};
+
+template<typename T, typename R, typename... Args>
+struct HandlerComponent : BasicHandlerComponent<T, std::function<R(Args...)>, R, Args...> {
+    using BasicHandlerComponent<T, std::function<R(Args...)>, R, Args...>::BasicHandlerComponent;
+};
+
+template<typename T, typename R, typename... Args>
+struct InplaceHandlerComponent : BasicHandlerComponent<T, InplaceFunction<R(Args...)>, R, Args...> {
+    using BasicHandlerComponent<T, InplaceFunction<R(Args...)>, R, Args...>::BasicHandlerComponent;
 };
@@ -0,0 +1,110 @@
+/*
+ * A std::function replacement that stores the callable inside the object itself.
+ *
+ * Registering a callback never heap-allocates: a callable that doesn't fit in Capacity
+ * bytes is a compile error rather than a silent allocation. Calling it is one indirect
+ * call through a function pointer, with no allocator or RTTI machinery in the way.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature, size_t Capacity = 4 * sizeof(void *)>
+struct InplaceFunction;
+
+template<typename R, typename... Args, size_t Capacity>
+struct InplaceFunction<R(Args...), Capacity> {
+    InplaceFunction() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction>>>
+    InplaceFunction(F &&f) {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= Capacity,
+                      "callable too large for InplaceFunction; capture less (e.g. just `this`) or raise Capacity");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "callable over-aligned for InplaceFunction");
+        static_assert(std::is_nothrow_move_constructible_v<Callable>, "callable must be nothrow movable");
+        new(&storage) Callable(std::forward<F>(f));
+        invoke = [](void *c, Args... args) -> R {
+            return (*static_cast<Callable *>(c))(std::forward<Args>(args)...);
+        };
+        manage = &manage_impl<Callable>;
+    }
+
+    InplaceFunction(InplaceFunction const &other) {
+        take(Op::Copy, const_cast<InplaceFunction &>(other));
+    }
+
+    InplaceFunction(InplaceFunction &&other) noexcept {
+        take(Op::Move, other);
+    }
+
+    InplaceFunction &operator=(InplaceFunction const &other) {
+        if (this != &other) {
+            reset();
+            take(Op::Copy, const_cast<InplaceFunction &>(other));
+        }
+        return *this;
+    }
+
+    InplaceFunction &operator=(InplaceFunction &&other) noexcept {
+        if (this != &other) {
+            reset();
+            take(Op::Move, other);
+        }
+        return *this;
+    }
+
+    ~InplaceFunction() {
+        reset();
+    }
+
+    R operator()(Args... args) const {
+        if (!invoke) throw std::bad_function_call();
+        return invoke(const_cast<void *>(static_cast<void const *>(&storage)), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return invoke != nullptr; }
+
+private:
+    enum struct Op {
+        Copy,
+        Move,
+        Destroy
+    };
+
+    template<typename Callable>
+    static void manage_impl(Op op, void *dst, void *src) {
+        switch (op) {
+            case Op::Copy:
+                new(dst) Callable(*static_cast<Callable const *>(src));
+                break;
+            case Op::Move:
+                new(dst) Callable(std::move(*static_cast<Callable *>(src)));
+                break;
+            case Op::Destroy:
+                static_cast<Callable *>(dst)->~Callable();
+                break;
+        }
+    }
+
+    /* copy or move other's callable into (empty) this */
+    void take(Op op, InplaceFunction &other) {
+        if (other.manage) other.manage(op, &storage, &other.storage);
+        invoke = other.invoke;
+        manage = other.manage;
+    }
+
+    void reset() {
+        if (manage) manage(Op::Destroy, &storage, nullptr);
+        invoke = nullptr;
+        manage = nullptr;
+    }
+
+    std::aligned_storage_t<Capacity, alignof(std::max_align_t)> storage;
+    R (*invoke)(void *, Args...) = nullptr;
+    void (*manage)(Op, void *, void *) = nullptr;
+};
@@ -0,0 +1,103 @@
+#include "Scheduler.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+void Scheduler::add_system(std::string name, Access access, std::function<void(float)> run) {
+    System system;
+    system.name = std::move(name);
+    system.access = access;
+    system.run = std::move(run);
+    systems.emplace_back(std::move(system));
+    waves_dirty = true;
+}
+
+void Scheduler::build_waves() {
+    waves.clear();
+    for (size_t j = 0; j < systems.size(); ++j) {
+        uint32_t wave = 0;
+        for (size_t i = 0; i < j; ++i) {
+            if (systems[i].access.conflicts(systems[j].access)) {
+                wave = std::max(wave, systems[i].wave + 1);
+            }
+        }
+        systems[j].wave = wave;
+        if (waves.size() <= wave) waves.resize(wave + 1);
+        waves[wave].emplace_back(j);
+    }
+    waves_dirty = false;
+}
+
+void Scheduler::run_system(System &system, float elapsed) {
+    auto before = std::chrono::steady_clock::now();
+    system.run(elapsed);
+    auto after = std::chrono::steady_clock::now();
+    system.last_ms = std::chrono::duration<float, std::milli>(after - before).count();
+    system.average_ms = 0.9f * system.average_ms + 0.1f * system.last_ms;
+}
+
+void Scheduler::run(float elapsed) {
+    if (waves_dirty) build_waves();
+
+    auto before = std::chrono::steady_clock::now();
+    std::vector<size_t> parallel;
+    for (std::vector<size_t> const &wave: waves) {
+        parallel.clear();
+        for (size_t index: wave) {
+            if (systems[index].access.main_thread) {
+                run_system(systems[index], elapsed);
+            } else {
+                parallel.emplace_back(index);
+            }
+        }
+        ThreadPool::get().parallel_for(parallel.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                run_system(systems[parallel[i]], elapsed);
+            }
+        });
+    }
+    auto after = std::chrono::steady_clock::now();
+    frame_ms = std::chrono::duration<float, std::milli>(after - before).count();
+
+    if (report_interval > 0.0f) {
+        since_report += elapsed;
+        if (since_report >= report_interval) {
+            since_report = 0.0f;
+            print_timings(std::cout);
+        }
+    }
+}
+
+std::vector<Scheduler::Timing> Scheduler::timings() const {
+    std::vector<Timing> ret;
+    ret.reserve(systems.size());
+    for (System const &system: systems) {
+        ret.emplace_back(Timing{system.name, system.wave, system.last_ms, system.average_ms});
+    }
+    return ret;
+}
+
+void Scheduler::print_timings(std::ostream &out) const {
+    out << "---- systems: " << std::fixed << std::setprecision(3) << frame_ms << " ms this frame ----\n";
+    for (System const &system: systems) {
+        out << "  [" << system.wave << "] " << std::left << std::setw(24) << system.name << std::right
+            << std::setw(9) << system.last_ms << " ms (avg " << system.average_ms << " ms)"
+            << (system.access.main_thread ? " main" : "") << "\n";
+    }
+    out << std::defaultfloat;
+    out.flush();
+}
+
+uint32_t Scheduler::next_type_index() {
+    static std::atomic<uint32_t> next{0};
+    uint32_t index = next++;
+    if (index >= MaxTypes) {
+        throw std::runtime_error("Scheduler: more than " + std::to_string(MaxTypes) + " types used in system accesses.");
+    }
+    return index;
+}
@@ -0,0 +1,110 @@
+/*
+ * Runs a frame's systems in dependency order, concurrently where they don't conflict.
+ *
+ * Each system declares the types it reads and writes (component types, or any other type
+ * standing for a piece of shared state). Two systems conflict if one writes something the
+ * other reads or writes; a conflicting pair always runs in the order the systems were added,
+ * which makes the systems a DAG. Every frame the DAG is run in waves (a system's wave is one
+ * more than that of the latest earlier system it conflicts with): systems in the same wave
+ * are independent and run together on ThreadPool::get(), and systems that must stay on the
+ * calling thread (GL, SDL, structural ECS changes) run there.
+ *
+ * The time each system took is recorded every frame; see timings() / print_timings().
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct Scheduler {
+    /*
+     * The data a system touches, e.g. Scheduler::Access().reads<WalkMesh>().writes<Scene::Transform>()
+     */
+    struct Access {
+        template<typename... Ts>
+        Access &reads() {
+            ((read |= type_bit<Ts>()), ...);
+            return *this;
+        }
+
+        template<typename... Ts>
+        Access &writes() {
+            ((write |= type_bit<Ts>()), ...);
+            return *this;
+        }
+
+        /* run on the thread that calls Scheduler::run */
+        Access &on_main_thread() {
+            main_thread = true;
+            return *this;
+        }
+
+        bool conflicts(Access const &other) const {
+            return (write & (other.read | other.write)) || (other.write & read);
+        }
+
+        uint64_t read = 0;
+        uint64_t write = 0;
+        bool main_thread = false;
+    };
+
+    /* systems run with the elapsed time passed to run() */
+    void add_system(std::string name, Access access, std::function<void(float)> run);
+
+    /* run every system once */
+    void run(float elapsed);
+
+    struct Timing {
+        std::string name;
+        uint32_t wave;
+        float last_ms; //time taken in the most recent run()
+        float average_ms; //exponential moving average over recent runs
+    };
+
+    /* per-system timings, in the order the systems were added */
+    std::vector<Timing> timings() const;
+
+    /* wall-clock time of the most recent run() */
+    float frame_ms = 0.0f;
+
+    void print_timings(std::ostream &out) const;
+
+    /* if > 0, run() prints the timings this often (in seconds) */
+    float report_interval = 0.0f;
+
+private:
+    struct System {
+        std::string name;
+        Access access;
+        std::function<void(float)> run;
+        uint32_t wave = 0;
+        float last_ms = 0.0f;
+        float average_ms = 0.0f;
+    };
+
+    std::vector<System> systems;
+
+    /* indices of systems by wave; rebuilt when systems are added */
+    std::vector<std::vector<size_t>> waves;
+    bool waves_dirty = true;
+
+    float since_report = 0.0f;
+
+    void build_waves();
+
+    void run_system(System &system, float elapsed);
+
+    /* each type named in an Access gets its own bit, on first use */
+    static constexpr uint32_t MaxTypes = 64;
+
+    template<typename T>
+    static uint64_t type_bit() {
+        static uint32_t const index = next_type_index();
+        return uint64_t(1) << index;
+    }
+
+    static uint32_t next_type_index();
+};
@@ -0,0 +1,185 @@
+/*
+ * Sparse-set storage for components.
+ *
+ * Components live packed in a dense array (with a parallel array of owning entity ids),
+ * and a paged sparse index maps entity id -> dense slot. Iteration is a linear scan over
+ * contiguous memory; find / emplace / erase are O(1) and never hash.
+ *
+ * Erase swaps the last element into the hole, so pointers/references into the set are
+ * invalidated by any emplace or erase. Component<T> defers both while a system is
+ * running, so references handed to a system callback stay valid for that callback.
+ *
+ * Each element also carries the change ticks at which it was added and last marked
+ * changed (see next_change_tick()), for systems that only want to process deltas.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*
+ * One counter shared by every component type: each add / mark_changed takes the next tick,
+ * so "changed since tick t" means "changed after the moment current_change_tick() was t".
+ */
+inline std::atomic<uint64_t> &change_tick_counter() {
+    static std::atomic<uint64_t> counter{0};
+    return counter;
+}
+
+inline uint64_t next_change_tick() {
+    return ++change_tick_counter();
+}
+
+inline uint64_t current_change_tick() {
+    return change_tick_counter().load();
+}
+
+template<typename T>
+struct SparseSet {
+    static constexpr uint32_t PageBits = 12;
+    static constexpr uint32_t PageSize = 1u << PageBits;
+    static constexpr uint32_t Empty = ~0u;
+
+    /*
+     * Look up the element owned by id (nullptr if there is none)
+     */
+    T *find(uint32_t id) {
+        uint32_t slot = slot_of(id);
+        return slot == Empty ? nullptr : &dense[slot];
+    }
+
+    T const *find(uint32_t id) const {
+        uint32_t slot = slot_of(id);
+        return slot == Empty ? nullptr : &dense[slot];
+    }
+
+    bool contains(uint32_t id) const {
+        return slot_of(id) != Empty;
+    }
+
+    /*
+     * Construct an element for id in place. Like std::unordered_map::emplace, an existing
+     * element is left untouched; the returned bool says whether an insert happened.
+     */
+    template<typename... Args>
+    std::pair<T *, bool> emplace(uint32_t id, Args &&... args) {
+        uint32_t &slot = sparse_slot(id);
+        if (slot != Empty) return {&dense[slot], false};
+        slot = uint32_t(dense.size());
+        dense.emplace_back(std::forward<Args>(args)...);
+        dense_ids.push_back(id);
+        uint64_t tick = next_change_tick();
+        added_ticks.push_back(tick);
+        changed_ticks.push_back(tick);
+        ++structure_version;
+        return {&dense.back(), true};
+    }
+
+    /*
+     * Remove the element owned by id (if any) by moving the last element into its slot
+     */
+    bool erase(uint32_t id) {
+        uint32_t slot = slot_of(id);
+        if (slot == Empty) return false;
+        uint32_t last = uint32_t(dense.size()) - 1;
+        if (slot != last) {
+            dense[slot] = std::move(dense[last]);
+            dense_ids[slot] = dense_ids[last];
+            added_ticks[slot] = added_ticks[last];
+            changed_ticks[slot] = changed_ticks[last];
+            sparse_slot(dense_ids[slot]) = slot;
+        }
+        dense.pop_back();
+        dense_ids.pop_back();
+        added_ticks.pop_back();
+        changed_ticks.pop_back();
+        pages[id >> PageBits][id & (PageSize - 1)] = Empty;
+        ++structure_version;
+        return true;
+    }
+
+    void clear() {
+        dense.clear();
+        dense_ids.clear();
+        added_ticks.clear();
+        changed_ticks.clear();
+        pages.clear();
+        ++structure_version;
+    }
+
+    /*
+     * Bumped whenever an element is inserted or erased; lets callers cache things derived
+     * from the set's membership (e.g. EventHandler's dispatch index)
+     */
+    uint64_t version() const { return structure_version; }
+
+    size_t size() const { return dense.size(); }
+
+    bool empty() const { return dense.empty(); }
+
+    /*
+     * Dense iteration: ids()[i] owns begin()[i]
+     */
+    typename std::vector<T>::iterator begin() { return dense.begin(); }
+
+    typename std::vector<T>::iterator end() { return dense.end(); }
+
+    std::vector<uint32_t> const &ids() const { return dense_ids; }
+
+    T *data() { return dense.data(); }
+
+    /*
+     * Stamp the element owned by id as changed now; returns false if there is none.
+     * (Safe to call concurrently for different ids.)
+     */
+    bool mark_changed(uint32_t id) {
+        uint32_t slot = slot_of(id);
+        if (slot == Empty) return false;
+        changed_ticks[slot] = next_change_tick();
+        return true;
+    }
+
+    /* ticks of the element at dense index i (parallel to ids()) */
+    uint64_t added_tick_at(size_t i) const { return added_ticks[i]; }
+
+    uint64_t changed_tick_at(size_t i) const { return changed_ticks[i]; }
+
+    /* tick at which id's element was last changed (or added); 0 if there is none */
+    uint64_t changed_tick(uint32_t id) const {
+        uint32_t slot = slot_of(id);
+        return slot == Empty ? 0 : changed_ticks[slot];
+    }
+
+    /* dense index of id's element, or Empty */
+    uint32_t index_of(uint32_t id) const { return slot_of(id); }
+
+private:
+    std::vector<T> dense;
+    std::vector<uint32_t> dense_ids;
+    std::vector<uint64_t> added_ticks;
+    std::vector<uint64_t> changed_ticks;
+    uint64_t structure_version = 0;
+
+    /* pages are allocated on first touch, so sparse ids only cost the pages they land in */
+    std::vector<std::unique_ptr<uint32_t[]>> pages;
+
+    uint32_t slot_of(uint32_t id) const {
+        uint32_t page = id >> PageBits;
+        if (page >= pages.size() || !pages[page]) return Empty;
+        return pages[page][id & (PageSize - 1)];
+    }
+
+    uint32_t &sparse_slot(uint32_t id) {
+        uint32_t page = id >> PageBits;
+        if (page >= pages.size()) pages.resize(page + 1);
+        if (!pages[page]) {
+            pages[page].reset(new uint32_t[PageSize]);
+            std::fill(pages[page].get(), pages[page].get() + PageSize, Empty);
+        }
+        return pages[page][id & (PageSize - 1)];
+    }
+};
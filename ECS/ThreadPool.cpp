@@ -0,0 +1,116 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+thread_local bool ThreadPool::in_task = false;
+
+ThreadPool::ThreadPool(size_t workers) {
+    if (workers == 0) {
+        size_t hardware = std::thread::hardware_concurrency();
+        workers = hardware > 1 ? hardware - 1 : 0;
+    }
+    for (size_t i = 0; i < workers + 1; ++i) {
+        queues.emplace_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        threads.emplace_back([this, i]() { worker_loop(i + 1); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+}
+
+ThreadPool &ThreadPool::get() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::dispatch(Job &job, size_t count, size_t grain) {
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+
+    size_t chunks = (count + grain - 1) / grain;
+    job.remaining = chunks;
+
+    /* deal contiguous chunks out round-robin; stealing evens out whatever imbalance is left */
+    for (size_t c = 0; c < chunks; ++c) {
+        Queue &queue = *queues[c % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{&job, c * grain, std::min(count, (c + 1) * grain)});
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        queued_tasks += chunks;
+    }
+    wake.notify_all();
+
+    /* help out until every chunk (including ones other threads took) is done */
+    while (job.remaining.load(std::memory_order_acquire) != 0) {
+        Task task;
+        if (acquire(0, task)) {
+            execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+bool ThreadPool::acquire(size_t self, Task &task) {
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            queued_tasks -= 1;
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue &victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            queued_tasks -= 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(Task const &task) {
+    bool was_in_task = in_task;
+    in_task = true;
+    try {
+        task.job->run(task.job->context, task.begin, task.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.job->error_mutex);
+        if (!task.job->error) task.job->error = std::current_exception();
+    }
+    in_task = was_in_task;
+    /* last touch of the job: the dispatching thread may return as soon as this hits zero */
+    task.job->remaining.fetch_sub(1, std::memory_order_release);
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    while (true) {
+        Task task;
+        if (acquire(self, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [this]() { return stopping || queued_tasks.load() != 0; });
+        if (stopping && queued_tasks.load() == 0) return;
+    }
+}
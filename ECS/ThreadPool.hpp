@@ -0,0 +1,100 @@
+/*
+ * A small work-stealing thread pool for data-parallel ECS systems.
+ *
+ * Each worker (and the calling thread) owns a deque of tasks. parallel_for splits a range
+ * into chunks and deals them out round-robin; a thread pops from the back of its own deque
+ * and, when that runs dry, steals from the front of someone else's. The calling thread
+ * works on the range too and returns once every chunk has finished.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct ThreadPool {
+    /* workers == 0 picks one worker per hardware thread, minus one for the caller */
+    explicit ThreadPool(size_t workers = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    /* The pool shared by Component<T>::par_system */
+    static ThreadPool &get();
+
+    /* Number of threads that run tasks, counting the caller of parallel_for */
+    size_t concurrency() const { return queues.size(); }
+
+    /*
+     * Call f(begin, end) over [0, count) in chunks of (at most) grain, spread across the pool.
+     * Blocks until all chunks are done; rethrows the first exception a chunk threw.
+     * Calls from inside a chunk run serially on the calling thread.
+     */
+    template<typename F>
+    void parallel_for(size_t count, size_t grain, F &&f) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        if (count <= grain || queues.size() == 1 || in_task) {
+            f(size_t(0), count);
+            return;
+        }
+        Job job;
+        job.context = &f;
+        job.run = [](void *context, size_t begin, size_t end) {
+            (*static_cast<std::remove_reference_t<F> *>(context))(begin, end);
+        };
+        dispatch(job, count, grain);
+    }
+
+private:
+    struct Job {
+        void *context = nullptr;
+        void (*run)(void *context, size_t begin, size_t end) = nullptr;
+        std::atomic<size_t> remaining{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        Job *job;
+        size_t begin, end;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void dispatch(Job &job, size_t count, size_t grain);
+
+    /* pop from our own queue, else steal from another; false if every queue is empty */
+    bool acquire(size_t self, Task &task);
+
+    void execute(Task const &task);
+
+    void worker_loop(size_t self);
+
+    /* queues[0] belongs to whichever thread calls parallel_for; queues[i + 1] to threads[i] */
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    /* idle workers sleep until tasks are queued (incremented under wake_mutex, so no lost wakeups) */
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued_tasks{0};
+    bool stopping = false; //guarded by wake_mutex
+
+    /* only one parallel_for drives the pool at a time (the caller owns queues[0]) */
+    std::mutex dispatch_mutex;
+
+    static thread_local bool in_task;
+};
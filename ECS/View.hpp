@@ -0,0 +1,115 @@
+/*
+ * Queries over entities that have several component types at once.
+ *
+ * View<A, B, ...>::each(f) calls f(A &, B &, ...) (or f(id, A &, B &, ...)) once for every
+ * entity that has all of the listed components. Iteration is driven by whichever of the
+ * component sets is currently smallest; the others are probed through their sparse index,
+ * so there is no hashing and entities missing a component are skipped after O(1) checks.
+ *
+ * Wrapping a type in Added<T> / Changed<T> only matches entities whose T was added / added
+ * or marked changed (Component<T>::mark_changed) after the tick passed to each(since, f);
+ * keep current_change_tick() from your previous run to process only the deltas.
+ *
+ * While each() runs, every listed component type counts as having a system running, so
+ * add_component / remove_component / entity destruction on those types is deferred until
+ * the outermost system or view over that type finishes (see Component<T>::SystemScope).
+ */
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "Component.hpp"
+
+/* query filters; the callback still receives T & */
+template<typename T>
+struct Added {
+};
+
+template<typename T>
+struct Changed {
+};
+
+namespace view_detail {
+template<typename Q>
+struct Query {
+    using Type = Q;
+
+    static bool passes(SparseSet<Q> const &, uint32_t, uint64_t) { return true; }
+};
+
+template<typename T>
+struct Query<Added<T>> {
+    using Type = T;
+
+    static bool passes(SparseSet<T> const &storage, uint32_t index, uint64_t since) {
+        return storage.added_tick_at(index) > since;
+    }
+};
+
+template<typename T>
+struct Query<Changed<T>> {
+    using Type = T;
+
+    static bool passes(SparseSet<T> const &storage, uint32_t index, uint64_t since) {
+        return storage.changed_tick_at(index) > since;
+    }
+};
+
+/* the element of Q's storage owned by id, if it exists and passes Q's filter */
+template<typename Q>
+typename Query<Q>::Type *probe(uint32_t id, uint64_t since) {
+    using T = typename Query<Q>::Type;
+    SparseSet<T> &storage = T::get_storage();
+    uint32_t index = storage.index_of(id);
+    if (index == SparseSet<T>::Empty || !Query<Q>::passes(storage, index, since)) return nullptr;
+    return storage.data() + index;
+}
+}
+
+template<typename... Qs>
+struct View {
+    static_assert(sizeof...(Qs) > 0, "View needs at least one component type");
+
+    /* visit every matching entity (Added / Changed filters match changes after tick `since`) */
+    template<typename F>
+    static void each(uint64_t since, F &&f) {
+        std::tuple<typename view_detail::Query<Qs>::Type::SystemScope...> scopes;
+        (void) scopes;
+
+        /* drive from the smallest set: any entity in the view must be in it */
+        std::vector<uint32_t> const *candidates[] = {&view_detail::Query<Qs>::Type::get_storage().ids()...};
+        size_t sizes[] = {view_detail::Query<Qs>::Type::get_storage().size()...};
+        size_t smallest = 0;
+        for (size_t i = 1; i < sizeof...(Qs); ++i) {
+            if (sizes[i] < sizes[smallest]) smallest = i;
+        }
+
+        /* storage is frozen for the loop (changes are deferred), so indexing the id array is safe */
+        std::vector<uint32_t> const &ids = *candidates[smallest];
+        for (size_t i = 0; i < ids.size(); ++i) {
+            uint32_t id = ids[i];
+            std::tuple<typename view_detail::Query<Qs>::Type *...> components(view_detail::probe<Qs>(id, since)...);
+            if (!std::apply([](auto *... c) { return ((c != nullptr) && ...); }, components)) continue;
+            if constexpr (std::is_invocable_v<F &, uint32_t, typename view_detail::Query<Qs>::Type &...>) {
+                std::apply([&](auto *... c) { f(id, *c...); }, components);
+            } else {
+                std::apply([&](auto *... c) { f(*c...); }, components);
+            }
+        }
+    }
+
+    template<typename F>
+    static void each(F &&f) {
+        each(0, std::forward<F>(f));
+    }
+
+    /* number of entities the view would visit */
+    static size_t count(uint64_t since = 0) {
+        size_t total = 0;
+        each(since, [&](typename view_detail::Query<Qs>::Type &...) { total += 1; });
+        return total;
+    }
+};
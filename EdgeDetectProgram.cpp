@@ -0,0 +1,102 @@
+#include "EdgeDetectProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+#include <string>
+
+Load< EdgeDetectProgram > edge_detect_horizontal_program(LoadTagEarly, []() -> EdgeDetectProgram const * {
+	return new EdgeDetectProgram(EdgeDetectProgram::Horizontal);
+});
+
+Load< EdgeDetectProgram > edge_detect_vertical_program(LoadTagEarly, []() -> EdgeDetectProgram const * {
+	return new EdgeDetectProgram(EdgeDetectProgram::Vertical);
+});
+
+EdgeDetectProgram::EdgeDetectProgram(Direction direction) {
+	std::string header = std::string("#version 330\n") + (direction == Horizontal ? "#define HORIZONTAL\n" : "");
+
+	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
+	program = gl_compile_program(
+		//vertex shader:
+		header +
+		"void main() {\n"
+		"	//one triangle that covers the whole viewport:\n"
+		"	gl_Position = vec4(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0, 0.0, 1.0);\n"
+		"}\n"
+	,
+		//fragment shader:
+		header +
+		"uniform sampler2D INPUT;\n"
+		"out float edge;\n"
+		"//1D factor of the outline kernel (its outer product with itself stands in for the old 5x5 kernel):\n"
+		"const float KERNEL[5] = float[5](0.2, 0.6, 1.0, 0.6, 0.2);\n"
+		"ivec2 last;\n"
+		"float at(ivec2 p) {\n"
+		"	return texelFetch(INPUT, clamp(p, ivec2(0), last), 0).x;\n"
+		"}\n"
+		"#ifdef HORIZONTAL\n"
+		"// Code adapted from https://github.com/aehmttw/Machimania/blob/master/resources/shaders/main.frag\n"
+		"float tex(ivec2 p) {\n"
+		"	return pow(1.0 - at(p), 0.1);\n"
+		"}\n"
+		"float outlineWeight(ivec2 p) {\n"
+		"	float a = 0.001;\n"
+		"	float b = 0.002;\n"
+		"	float v = abs(tex(p - ivec2(1, 0)) - tex(p)) + abs(tex(p - ivec2(0, 1)) - tex(p));\n"
+		"	return clamp((v - a) / (b - a), 0.0, 1.0);\n"
+		"}\n"
+		"#endif\n"
+		"void main() {\n"
+		"	last = textureSize(INPUT, 0) - 1;\n"
+		"	ivec2 p = ivec2(gl_FragCoord.xy);\n"
+		"	float sum = 0.0;\n"
+		"	for (int i = 0; i < 5; ++i) {\n"
+		"#ifdef HORIZONTAL\n"
+		"		sum += KERNEL[i] * outlineWeight(p + ivec2(i - 2, 0));\n"
+		"#else\n"
+		"		sum += KERNEL[i] * at(p + ivec2(0, i - 2));\n"
+		"#endif\n"
+		"	}\n"
+		"	edge = sum;\n"
+		"}\n"
+	);
+	//As you can see above, adjacent strings in C/C++ are concatenated.
+	// this is very useful for writing long shader programs inline.
+
+	GLuint INPUT_sampler2D = glGetUniformLocation(program, "INPUT");
+
+	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
+
+	glUniform1i(INPUT_sampler2D, 0); //set INPUT to sample from GL_TEXTURE0
+
+	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+
+	GL_ERRORS();
+}
+
+EdgeDetectProgram::~EdgeDetectProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
+
+void EdgeDetectProgram::draw(GLuint input) const {
+	//(the triangle's corners come from gl_VertexID, but a vertex array still has to be bound)
+	static GLuint empty_vao = 0;
+	if (empty_vao == 0) glGenVertexArrays(1, &empty_vao);
+
+	glUseProgram(program);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, input);
+	glDisable(GL_DEPTH_TEST);
+
+	glBindVertexArray(empty_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glEnable(GL_DEPTH_TEST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
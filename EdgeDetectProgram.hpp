@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Full-screen post-process that turns the depth pre-pass into ComicBookProgram's outline mask, once per pixel
+// (instead of ComicBookProgram re-running a 5x5 kernel of depth lookups for every shaded fragment):
+// the kernel is applied as two 1D passes -- Horizontal reads the depth texture and writes the outline
+// weights blurred along rows, Vertical blurs those along columns into the mask ComicBookProgram samples.
+// Draw into a single-channel float (e.g. GL_R16F) target the size of the depth texture.
+struct EdgeDetectProgram {
+	enum Direction { Horizontal, Vertical };
+	EdgeDetectProgram(Direction direction);
+	~EdgeDetectProgram();
+
+	GLuint program = 0;
+
+	//Textures:
+	//TEXTURE0 - the input: depth texture (Horizontal) or Horizontal's output (Vertical)
+
+	//run the pass over the current viewport (binds 'input' to TEXTURE0; leaves depth testing on):
+	void draw(GLuint input) const;
+};
+
+extern Load< EdgeDetectProgram > edge_detect_horizontal_program;
+extern Load< EdgeDetectProgram > edge_detect_vertical_program;
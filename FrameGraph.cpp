@@ -0,0 +1,117 @@
+#include "FrameGraph.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <unordered_set>
+
+void FrameGraph::clear() {
+	passes.clear();
+}
+
+void FrameGraph::add_pass(std::string name, Access access, std::function< void() > run) {
+	Pass pass;
+	pass.record = record_for(name);
+	pass.name = std::move(name);
+	pass.access = std::move(access);
+	pass.run = std::move(run);
+	passes.emplace_back(std::move(pass));
+}
+
+size_t FrameGraph::record_for(std::string const &name) {
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (records[i].name == name) return i;
+	}
+	records.emplace_back();
+	records.back().name = name;
+	return records.size() - 1;
+}
+
+void FrameGraph::run() {
+	//walk backwards, tracking which resources' current contents are still needed:
+	std::unordered_set< std::string > needed(outputs.begin(), outputs.end());
+	for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+		auto is_needed = [&needed](std::string const &resource) { return needed.count(resource) != 0; };
+		pass->live = std::any_of(pass->access.write.begin(), pass->access.write.end(), is_needed)
+		          || std::any_of(pass->access.clear.begin(), pass->access.clear.end(), is_needed);
+		if (!pass->live) continue;
+		//(what it writes stays needed -- it draws on top of it -- but what it clears doesn't)
+		for (std::string const &resource : pass->access.clear) needed.erase(resource);
+		for (std::string const &resource : pass->access.read) needed.insert(resource);
+	}
+
+	uint32_t slot = frame % QueryFrames;
+	for (Record &record : records) record.ran = false;
+	for (Pass &pass : passes) {
+		if (!pass.live) continue;
+		Record &record = records[pass.record];
+
+		//collect the GPU time this slot measured QueryFrames ago (if it's ready; otherwise skip it):
+		if (record.queries[slot] == 0) glGenQueries(QueryFrames, record.queries);
+		if (record.issued[slot]) {
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(record.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+				GLuint64 ns = 0;
+				glGetQueryObjectui64v(record.queries[slot], GL_QUERY_RESULT, &ns);
+				record.gpu_ms = float(ns) * 1e-6f;
+				record.average_gpu_ms = 0.9f * record.average_gpu_ms + 0.1f * record.gpu_ms;
+			}
+		}
+
+		glBeginQuery(GL_TIME_ELAPSED, record.queries[slot]);
+		auto before = std::chrono::steady_clock::now();
+		pass.run();
+		auto after = std::chrono::steady_clock::now();
+		glEndQuery(GL_TIME_ELAPSED);
+		record.issued[slot] = true;
+
+		record.ran = true;
+		record.cpu_ms = std::chrono::duration< float, std::milli >(after - before).count();
+		record.average_cpu_ms = 0.9f * record.average_cpu_ms + 0.1f * record.cpu_ms;
+	}
+	frame += 1;
+
+	GL_ERRORS();
+
+	if (report_interval > 0.0f) {
+		auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration< float >(now - last_report).count() >= report_interval) {
+			last_report = now;
+			print_timings(std::cout);
+		}
+	}
+}
+
+std::vector< FrameGraph::Timing > FrameGraph::timings() const {
+	std::vector< Timing > ret;
+	ret.reserve(passes.size());
+	for (Pass const &pass : passes) {
+		Record const &record = records[pass.record];
+		ret.emplace_back(Timing{pass.name, record.ran, record.cpu_ms, record.gpu_ms, record.average_cpu_ms, record.average_gpu_ms});
+	}
+	return ret;
+}
+
+void FrameGraph::print_timings(std::ostream &out) const {
+	out << "---- render passes (cpu / gpu) ----\n" << std::fixed << std::setprecision(3);
+	for (Timing const &timing : timings()) {
+		out << "  " << std::left << std::setw(16) << timing.name << std::right;
+		if (!timing.ran) {
+			out << "  (dropped)\n";
+			continue;
+		}
+		out << std::setw(9) << timing.cpu_ms << " / " << std::setw(7) << timing.gpu_ms << " ms"
+		    << " (avg " << timing.average_cpu_ms << " / " << timing.average_gpu_ms << " ms)\n";
+	}
+	out << std::defaultfloat;
+	out.flush();
+}
+
+FrameGraph::~FrameGraph() {
+	for (Record &record : records) {
+		if (record.queries[0] != 0) glDeleteQueries(QueryFrames, record.queries);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+ * A frame's rendering as a list of passes over named resources (e.g. "depth", "shadow_map",
+ * "backbuffer"):
+ *  - each pass declares what it reads, what it draws on top of ("writes"), and what it replaces
+ *    outright ("clears"),
+ *  - run() walks the passes backwards from the graph's outputs and drops every pass whose results
+ *    nothing uses -- passes nobody reads, and passes whose results are cleared again before anyone
+ *    reads them -- then runs the rest in the order they were added,
+ *  - each pass run is timed on the CPU and (with GL_TIME_ELAPSED queries, read back a few frames
+ *    later so nothing stalls) on the GPU; see timings() / print_timings().
+ *
+ * Passes are declared again every frame (clear(), add_pass()...), so their functions can capture
+ * that frame's locals; timings are kept by pass name across frames.
+ */
+
+#include "GL.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct FrameGraph {
+	//the resources a pass touches, e.g. FrameGraph::Access().reads("depth").clears("backbuffer"):
+	struct Access {
+		Access &reads(std::string const &resource) { read.emplace_back(resource); return *this; }
+		Access &writes(std::string const &resource) { write.emplace_back(resource); return *this; }
+		Access &clears(std::string const &resource) { clear.emplace_back(resource); return *this; }
+
+		std::vector< std::string > read;
+		std::vector< std::string > write; //drawn on top of (so the earlier contents are needed too)
+		std::vector< std::string > clear; //replaced entirely (so the earlier contents are not)
+	};
+
+	//start declaring a new frame's passes:
+	void clear();
+
+	void add_pass(std::string name, Access access, std::function< void() > run);
+
+	//resources the frame has to produce; passes that don't contribute to these are dropped:
+	std::vector< std::string > outputs = {"backbuffer"};
+
+	//drop unneeded passes, then run the others in order:
+	void run();
+
+	struct Timing {
+		std::string name;
+		bool ran; //false if the pass was dropped last frame
+		float cpu_ms; //time the pass's function took (most recent run)
+		float gpu_ms; //GPU time of its commands (most recent result available)
+		float average_cpu_ms; //exponential moving averages over recent runs
+		float average_gpu_ms;
+	};
+
+	//per-pass timings, in the order the passes were last declared:
+	std::vector< Timing > timings() const;
+
+	void print_timings(std::ostream &out) const;
+
+	//if > 0, run() prints the timings this often (in seconds):
+	float report_interval = 0.0f;
+
+	~FrameGraph();
+
+private:
+	struct Pass {
+		std::string name;
+		Access access;
+		std::function< void() > run;
+		size_t record; //index into records
+		bool live = false;
+	};
+	std::vector< Pass > passes;
+
+	//per-pass-name state that lasts across frames:
+	static constexpr uint32_t QueryFrames = 4; //GPU results are read this many frames after they're issued
+	struct Record {
+		std::string name;
+		bool ran = false;
+		float cpu_ms = 0.0f, gpu_ms = 0.0f;
+		float average_cpu_ms = 0.0f, average_gpu_ms = 0.0f;
+		GLuint queries[QueryFrames] = {0, 0, 0, 0};
+		bool issued[QueryFrames] = {false, false, false, false};
+	};
+	std::vector< Record > records;
+	size_t record_for(std::string const &name);
+
+	uint32_t frame = 0;
+	std::chrono::steady_clock::time_point last_report = std::chrono::steady_clock::now();
+};
@@ -0,0 +1,81 @@
+#include "Frustum.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+Frustum::Frustum(glm::mat4 const &world_to_clip) {
+	//(Gribb & Hartmann) with clip = M * p, the plane x >= -w is (row 3 + row 0) . p >= 0, etc.:
+	auto row = [&world_to_clip](int r) {
+		return glm::vec4(world_to_clip[0][r], world_to_clip[1][r], world_to_clip[2][r], world_to_clip[3][r]);
+	};
+	glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+	planes[0] = w + x; //left
+	planes[1] = w - x; //right
+	planes[2] = w + y; //bottom
+	planes[3] = w - y; //top
+	planes[4] = w + z; //near
+	planes[5] = w - z; //far (for an infinite projection, (0,0,0,+) -- which keeps everything)
+}
+
+void Frustum::Boxes::clear() {
+	cx.clear(); cy.clear(); cz.clear();
+	ex.clear(); ey.clear(); ez.clear();
+}
+
+void Frustum::Boxes::push_back(glm::vec3 const &center, glm::vec3 const &extent) {
+	cx.emplace_back(center.x); cy.emplace_back(center.y); cz.emplace_back(center.z);
+	ex.emplace_back(extent.x); ey.emplace_back(extent.y); ez.emplace_back(extent.z);
+}
+
+bool Frustum::test(glm::vec3 const &center, glm::vec3 const &extent) const {
+	for (glm::vec4 const &plane : planes) {
+		//signed (scaled) distance of the center, and the box's (scaled) radius along the plane normal:
+		float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		float radius = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+		if (distance + radius < 0.0f) return false;
+	}
+	return true;
+}
+
+void Frustum::test(Boxes const &boxes, std::vector< uint8_t > &inside) const {
+	size_t count = boxes.size();
+	assert(boxes.cy.size() == count && boxes.cz.size() == count);
+	assert(boxes.ex.size() == count && boxes.ey.size() == count && boxes.ez.size() == count);
+	inside.resize(count);
+
+	size_t i = 0;
+#ifdef FRUSTUM_SSE
+	//four boxes at a time, against each plane in turn:
+	__m128 const zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4) {
+		__m128 cx = _mm_loadu_ps(&boxes.cx[i]), cy = _mm_loadu_ps(&boxes.cy[i]), cz = _mm_loadu_ps(&boxes.cz[i]);
+		__m128 ex = _mm_loadu_ps(&boxes.ex[i]), ey = _mm_loadu_ps(&boxes.ey[i]), ez = _mm_loadu_ps(&boxes.ez[i]);
+		__m128 outside = _mm_setzero_ps(); //(all-ones lanes once a plane rejects the box)
+		for (glm::vec4 const &plane : planes) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), ey)),
+				_mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+		int mask = _mm_movemask_ps(outside);
+		inside[i + 0] = !(mask & 1);
+		inside[i + 1] = !(mask & 2);
+		inside[i + 2] = !(mask & 4);
+		inside[i + 3] = !(mask & 8);
+	}
+#endif
+	//(the rest one at a time)
+	for (; i < count; ++i) {
+		inside[i] = test(
+			glm::vec3(boxes.cx[i], boxes.cy[i], boxes.cz[i]),
+			glm::vec3(boxes.ex[i], boxes.ey[i], boxes.ez[i]));
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+ * View-frustum culling: the six planes of a clip volume, pulled out of a world-to-clip matrix,
+ * tested against world-space axis-aligned boxes (center +/- extent):
+ *  - boxes are stored as parallel arrays, so four of them are tested per plane at once (SSE when
+ *    available),
+ *  - the test is conservative: a box that is outside the volume but not entirely outside any one
+ *    plane (e.g. near a corner) counts as inside.
+ *
+ * Scene::cull() uses this to find the drawables a view can see.
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct Frustum {
+	//planes of the volume where -w <= x, y, z <= w in clip space:
+	explicit Frustum(glm::mat4 const &world_to_clip);
+
+	//plane i keeps points p with dot(planes[i].xyz, p) + planes[i].w >= 0 (not normalized):
+	glm::vec4 planes[6];
+
+	//a batch of boxes, one lane per box:
+	struct Boxes {
+		std::vector< float > cx, cy, cz; //centers
+		std::vector< float > ex, ey, ez; //half-extents (non-negative)
+
+		size_t size() const { return cx.size(); }
+		void clear();
+		void push_back(glm::vec3 const &center, glm::vec3 const &extent);
+	};
+
+	//inside[i] = does box i (possibly) touch the volume?
+	void test(Boxes const &boxes, std::vector< uint8_t > &inside) const;
+
+	//single-box version of the above:
+	bool test(glm::vec3 const &center, glm::vec3 const &extent) const;
+};
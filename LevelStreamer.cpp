@@ -0,0 +1,213 @@
+#include "LevelStreamer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+LevelStreamer::LevelStreamer(size_t upload_bytes_per_frame_) : upload_bytes_per_frame(upload_bytes_per_frame_) {
+	loader = std::thread([this]() { loader_main(); });
+}
+
+LevelStreamer::~LevelStreamer() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	loader.join();
+
+	for (auto &[name, level] : levels) {
+		unload(level);
+	}
+}
+
+void LevelStreamer::add(std::string const &name, Desc const &desc) {
+	std::unique_lock< std::mutex > lock(mutex);
+	auto ret = levels.emplace(name, Level());
+	if (!ret.second) {
+		throw std::runtime_error("LevelStreamer: level '" + name + "' was added twice.");
+	}
+	ret.first->second.name = name;
+	ret.first->second.desc = desc;
+}
+
+LevelStreamer::Level &LevelStreamer::level(std::string const &name) {
+	auto f = levels.find(name);
+	if (f == levels.end()) {
+		throw std::runtime_error("LevelStreamer: no level named '" + name + "'.");
+	}
+	return f->second;
+}
+
+void LevelStreamer::request(std::string const &name) {
+	std::unique_lock< std::mutex > lock(mutex);
+	Level &l = level(name);
+	l.evict_when_read = false;
+	if (l.state == Level::Unloaded) {
+		l.state = Level::Queued;
+		queue.emplace_back(&l);
+		wake.notify_one();
+	}
+}
+
+LevelStreamer::Level &LevelStreamer::finish(std::string const &name) {
+	request(name);
+
+	Level *l = nullptr;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		l = &level(name);
+		read_done.wait(lock, [l]() { return l->state == Level::Read || l->state == Level::Ready; });
+	}
+	if (l->state == Level::Read) {
+		if (l->error) {
+			std::exception_ptr error = l->error;
+			unload(*l);
+			std::rethrow_exception(error);
+		}
+		upload_slice(*l, size_t(-1));
+	}
+	return *l;
+}
+
+LevelStreamer::Level *LevelStreamer::get(std::string const &name) {
+	std::unique_lock< std::mutex > lock(mutex);
+	Level &l = level(name);
+	return l.state == Level::Ready ? &l : nullptr;
+}
+
+void LevelStreamer::evict(std::string const &name) {
+	std::unique_lock< std::mutex > lock(mutex);
+	Level &l = level(name);
+	if (l.state == Level::Queued) {
+		queue.erase(std::find(queue.begin(), queue.end(), &l));
+		l.state = Level::Unloaded;
+	} else if (l.state == Level::Reading) {
+		//the loading thread owns it until it's read; update() will unload it then:
+		l.evict_when_read = true;
+	} else if (l.state == Level::Read || l.state == Level::Ready) {
+		lock.unlock();
+		unload(l);
+	}
+}
+
+void LevelStreamer::update() {
+	//levels the loading thread is done with belong to this thread:
+	std::vector< Level * > done;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		done.assign(read.begin(), read.end());
+	}
+
+	bool uploading = false;
+	for (Level *l : done) {
+		if (l->evict_when_read) {
+			unload(*l);
+		} else if (l->error) {
+			std::exception_ptr error = l->error;
+			unload(*l);
+			std::rethrow_exception(error);
+		} else if (!uploading) {
+			//one slice per frame, to the earliest-read level first so it is usable soonest:
+			upload_slice(*l, upload_bytes_per_frame);
+			uploading = true;
+		}
+	}
+}
+
+bool LevelStreamer::upload_slice(Level &l, size_t max_bytes) {
+	if (!l.meshes->upload(max_bytes)) return false;
+	if (!l.scene->upload_static_batches(max_bytes)) return false;
+
+	if (l.desc.on_uploaded) l.desc.on_uploaded(l);
+	GL_ERRORS();
+
+	std::unique_lock< std::mutex > lock(mutex);
+	read.erase(std::remove(read.begin(), read.end(), &l), read.end());
+	l.state = Level::Ready;
+	return true;
+}
+
+void LevelStreamer::unload(Level &l) {
+	for (auto &[name, vao] : l.vaos) {
+		glDeleteVertexArrays(1, &vao);
+	}
+	l.vaos.clear();
+	l.mesh_transforms.clear();
+	l.scene.reset();
+	l.walkmeshes.reset();
+	l.baked.reset();
+	l.meshes.reset();
+	l.error = nullptr;
+
+	std::unique_lock< std::mutex > lock(mutex);
+	read.erase(std::remove(read.begin(), read.end(), &l), read.end());
+	l.evict_when_read = false;
+	l.state = Level::Unloaded;
+}
+
+//--------------------------------------------------------------
+//loading thread
+
+void LevelStreamer::loader_main() {
+	while (true) {
+		Level *l = nullptr;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			wake.wait(lock, [this]() { return quit || !queue.empty(); });
+			if (quit) return;
+			l = queue.front();
+			queue.pop_front();
+			l->state = Level::Reading;
+		}
+
+		//(nothing else touches a Reading level's data, so this runs unlocked)
+		try {
+			read_level(*l);
+		} catch (...) {
+			l->error = std::current_exception();
+		}
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			l->state = Level::Read;
+			read.emplace_back(l);
+		}
+		read_done.notify_all();
+	}
+}
+
+void LevelStreamer::read_level(Level &l) {
+	l.meshes = std::make_unique< MeshBuffer >(l.desc.meshes_file, MeshBuffer::DeferUpload());
+
+	l.scene = std::make_unique< Scene >();
+	l.scene->load(l.desc.scene_file, [&l](Scene &, Scene::Transform *transform, std::string const &mesh_name) {
+		l.mesh_transforms[mesh_name] = transform;
+		if (l.desc.on_drawable) l.desc.on_drawable(l, transform, mesh_name);
+	});
+
+	//(while the vertex data is still in memory; wireframe objects are only flagged dynamic later, so they
+	// may get batched too, but are then drawn on their own)
+	l.scene->build_static_batches(*l.meshes);
+
+	if (!l.desc.walkmeshes_file.empty()) {
+		l.walkmeshes = std::make_unique< WalkMeshes >(l.desc.walkmeshes_file);
+	}
+
+	if (!l.desc.baked_file.empty() && std::ifstream(l.desc.baked_file).good()) {
+		//(a size / modification time check, so the sources aren't read just to see if they changed;
+		// a file from an older bake-scene counts as out of date too)
+		try {
+			l.baked = std::make_unique< BakedScene >(l.desc.baked_file);
+		} catch (std::exception &e) {
+			std::cerr << "WARNING: " << e.what() << std::endl;
+		}
+		if (!l.baked || !l.baked->up_to_date(l.desc.scene_file, l.desc.meshes_file)) {
+			std::cerr << "WARNING: '" << l.desc.baked_file << "' is out of date; re-run bake-scene. (Setting up the scene at load time instead.)" << std::endl;
+			l.baked.reset();
+		}
+	}
+}
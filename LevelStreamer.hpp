@@ -0,0 +1,122 @@
+#pragma once
+
+/*
+ * Streams levels (a MeshBuffer, a Scene and its WalkMeshes) in and out while the game runs:
+ *  - request() queues a level; a background thread reads and parses its files
+ *  - update(), called once per frame on the OpenGL thread, uploads the parsed vertex data (and then
+ *    the scene's static batches; see Scene::build_static_batches) a slice (upload_bytes_per_frame) at
+ *    a time and then calls the level's on_uploaded hook
+ *  - evict() frees a level's CPU and GPU memory
+ * so only the levels around the player need to be resident, and loading the next one doesn't stall
+ * a frame.
+ *
+ * finish() loads a level completely before returning (e.g. the first level, at startup).
+ */
+
+#include "BakedScene.hpp"
+#include "Mesh.hpp"
+#include "Scene.hpp"
+#include "WalkMesh.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct LevelStreamer {
+	struct Level;
+
+	//where a level's data comes from and how to finish setting it up:
+	struct Desc {
+		std::string meshes_file;
+		std::string scene_file;
+		std::string walkmeshes_file;
+		//optional output of bake-scene for scene_file + meshes_file (ignored if missing or stale):
+		std::string baked_file;
+
+		//called on the loading thread for each drawable in the scene file (like Scene::load's on_drawable);
+		// meshes aren't uploaded yet, so leave pipeline.vao to on_uploaded:
+		std::function< void(Level &, Scene::Transform *, std::string const &mesh_name) > on_drawable;
+
+		//called on the OpenGL thread once the meshes are uploaded (e.g. to make vertex arrays):
+		std::function< void(Level &) > on_uploaded;
+	};
+
+	struct Level {
+		enum State {
+			Unloaded,
+			Queued, //waiting for the loading thread
+			Reading, //being read by the loading thread
+			Read, //parsed; waiting for update() to upload it
+			Ready,
+		};
+
+		std::string name;
+		Desc desc;
+		State state = Unloaded;
+		bool evict_when_read = false; //evict() was called while the level was being read
+
+		std::unique_ptr< MeshBuffer > meshes;
+		std::unique_ptr< Scene > scene;
+		std::unique_ptr< WalkMeshes > walkmeshes;
+		std::unique_ptr< BakedScene > baked; //nullptr if there was no up-to-date baked scene
+
+		//mesh name -> transform of each drawable in 'scene':
+		std::unordered_map< std::string, Scene::Transform * > mesh_transforms;
+
+		//vertex arrays made by on_uploaded (deleted on eviction):
+		std::unordered_map< std::string, GLuint > vaos;
+
+		std::exception_ptr error; //from reading the level; rethrown by update() / finish()
+	};
+
+	explicit LevelStreamer(size_t upload_bytes_per_frame = 4 << 20);
+	~LevelStreamer();
+
+	LevelStreamer(LevelStreamer const &) = delete;
+	LevelStreamer &operator=(LevelStreamer const &) = delete;
+
+	void add(std::string const &name, Desc const &desc);
+
+	//start loading the level in the background (does nothing if it is loading or loaded):
+	void request(std::string const &name);
+
+	//load the level now (waiting for it to be read, and uploading it all at once):
+	Level &finish(std::string const &name);
+
+	//the level if it is Ready, otherwise nullptr:
+	Level *get(std::string const &name);
+
+	//free everything the level loaded; it can be requested again later:
+	void evict(std::string const &name);
+
+	//advance uploads by one slice; call once per frame on the OpenGL thread:
+	// throws if a level failed to load
+	void update();
+
+	size_t upload_bytes_per_frame;
+
+private:
+	Level &level(std::string const &name);
+	void loader_main();
+	static void read_level(Level &level);
+	void unload(Level &level);
+	bool upload_slice(Level &level, size_t max_bytes);
+
+	std::map< std::string, Level > levels;
+
+	//guards every Level::state, the queue and the fields the loading thread fills in:
+	std::mutex mutex;
+	std::condition_variable wake; //loading thread: something was queued
+	std::condition_variable read_done; //finish(): a level finished reading
+	std::deque< Level * > queue;
+	std::deque< Level * > read; //Read levels, in the order the loading thread finished them
+	bool quit = false;
+	std::thread loader;
+};
@@ -138,6 +138,7 @@ const game_names = [
     maek.CPP('PauseMode.cpp'),
     maek.CPP('main.cpp'),
     maek.CPP('ComicBookProgram.cpp'),
+    maek.CPP('EdgeDetectProgram.cpp'),
     maek.CPP('ShadowProgram.cpp'),
     maek.CPP('RocketColorTextureProgram.cpp'),
     maek.CPP('TextureProgram.cpp'),
@@ -155,7 +156,16 @@ const common_names = [
     maek.CPP('DrawLines.cpp'),
     maek.CPP('ColorProgram.cpp'),
     maek.CPP('Scene.cpp'),
+    maek.CPP('RenderQueue.cpp'),
+    maek.CPP('UniformBlocks.cpp'),
+    maek.CPP('BakedScene.cpp'),
+    maek.CPP('LevelStreamer.cpp'),
+    maek.CPP('TransformHierarchy.cpp'),
+    maek.CPP('Frustum.cpp'),
+    maek.CPP('FrameGraph.cpp'),
     maek.CPP('Mesh.cpp'),
+    maek.CPP('ChunkReader.cpp'),
+    maek.CPP('NameIndex.cpp'),
     maek.CPP('load_save_png.cpp'),
     maek.CPP('gl_compile_program.cpp'),
     maek.CPP('Mode.cpp'),
@@ -168,6 +178,8 @@ const common_names = [
     maek.CPP('ECS/Components/TerminalCommandHandler.cpp'),
     maek.CPP('ECS/Components/TerminalDeactivateHandler.cpp'),
     maek.CPP('ECS/HandlerComponent.cpp'),
+    maek.CPP('ECS/ThreadPool.cpp'),
+    maek.CPP('ECS/Scheduler.cpp'),
     maek.CPP('spline.cpp'),
     maek.CPP('Terminal.cpp'),
     maek.CPP('TextDisplay.cpp'),
@@ -196,6 +208,12 @@ const game_exe = maek.LINK([...game_names, ...common_names], 'dist/game');
 // const show_meshes_exe = maek.LINK([...show_meshes_names, ...common_names], 'scenes/show-meshes');
 // const show_scene_exe = maek.LINK([...show_scene_names, ...common_names], 'scenes/show-scene');
 
+//ECS microbenchmarks (not built by default; run `node Maekfile.js dist/ecs-bench`, then `dist/ecs-bench --json out.json`):
+const ecs_bench_exe = maek.LINK([maek.CPP('ecs-bench.cpp'), maek.CPP('ECS/Entity.cpp'), maek.CPP('ECS/ThreadPool.cpp')], 'dist/ecs-bench');
+
+//scene baker (not built by default; scenes/Makefile runs it to make dist/resources/*.baked):
+const bake_scene_exe = maek.LINK([maek.CPP('bake-scene.cpp'), ...common_names], 'dist/bake-scene');
+
 //set the default target to the game (and copy the readme files):
 maek.TARGETS = [game_exe, ...copies];
 
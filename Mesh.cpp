@@ -1,54 +1,70 @@
 #include "Mesh.hpp"
-#include "read_write_chunk.hpp"
 
 #include <glm/glm.hpp>
 
 #include <stdexcept>
-#include <fstream>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <set>
+#include <algorithm>
 #include <cstddef>
 
-MeshBuffer::MeshBuffer(std::string const &filename) {
-    glGenBuffers(1, &buffer);
-    
-    std::ifstream file(filename, std::ios::binary);
+char const *MeshBuffer::BarycentricVertexGLSL =
+    "layout(location = 15) in vec3 Barycentric;\n" //(the last of the 16 locations GL 3.3 guarantees)
+    "out vec3 barycentric;\n";
+
+char const *MeshBuffer::BarycentricFragmentGLSL =
+    "in vec3 barycentric;\n"
+    "//is this fragment more than about a pixel from all of its triangle's edges?\n"
+    "bool offWireframe() {\n"
+    "    vec3 pixels = barycentric / max(fwidth(barycentric), vec3(1e-6));\n"
+    "    return min(min(pixels.x, pixels.y), pixels.z) > 1.0;\n"
+    "}\n";
+
+//each vertex's corner of its triangle, counting triangles from 'begin':
+static void set_barycentrics(std::vector< glm::u8vec4 > &barycentrics, uint32_t begin, uint32_t end) {
+    for (uint32_t v = begin; v < end; ++v) {
+        glm::u8vec4 &b = barycentrics[v];
+        b = glm::u8vec4(0);
+        b[(v - begin) % 3] = 0xff;
+    }
+}
+
+MeshBuffer::MeshBuffer(std::string const &filename) : MeshBuffer(filename, DeferUpload()) {
+    upload();
+}
+
+MeshBuffer::MeshBuffer(std::string const &filename, DeferUpload) {
+    //(the file stays mapped until upload() is done with the vertex data)
+    pending_file = std::make_unique<ChunkReader>(filename);
+    ChunkReader &file = *pending_file;
     
     GLuint total = 0;
     
-    struct Vertex {
-        glm::vec3 Position;
-        glm::vec3 Normal;
-        glm::u8vec4 Color;
-        glm::vec2 TexCoord;
-    };
-    static_assert(sizeof(Vertex) == 3 * 4 + 3 * 4 + 4 * 1 + 2 * 4, "Vertex is packed.");
-    std::vector<Vertex> data;
+    ChunkSpan<Vertex> data;
     
-    //read + upload data chunk:
+    //read data chunk:
     if (filename.size() >= 5 && filename.substr(filename.size() - 5) == ".pnct") {
-        read_chunk(file, "pnct", &data);
+        data = file.read<Vertex>("pnct");
         
-        //upload data:
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
-        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(Vertex), data.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        //keep data for upload():
+        pending.data = reinterpret_cast<char const *>(data.data);
+        pending.count = data.size() * sizeof(Vertex);
         
         total = GLuint(data.size()); //store total for later checks on index
         
         //store attrib locations:
-        Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
-        Normal = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Normal));
-        Color = Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), offsetof(Vertex, Color));
-        TexCoord = Attrib(2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, TexCoord));
+        set_vertex_attribs();
     } else {
         throw std::runtime_error("Unknown file type '" + filename + "'");
     }
     
-    std::vector<char> strings;
-    read_chunk(file, "str0", &strings);
+    ChunkSpan<char> strings = file.read<char>("str0");
+    
+    //(barycentrics are counted from the start of each mesh, below; from 0 elsewhere)
+    pending_barycentrics.resize(total);
+    set_barycentrics(pending_barycentrics, 0, total);
     
     { //read index chunk, add to meshes:
         struct IndexEntry {
@@ -58,23 +74,14 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
         };
         static_assert(sizeof(IndexEntry) == 24, "Index entry should be packed");
         
-        std::vector<IndexEntry> index;
-        read_chunk(file, "idx0", &index);
+        ChunkSpan<IndexEntry> index = file.read<IndexEntry>("idx0");
         
         for (auto const &entry: index) {
-            if (!(entry.name_begin <= entry.name_end && entry.name_end <= strings.size())) {
-                throw std::runtime_error("index entry has out-of-range name begin/end");
-            }
-            if (!(entry.collection_name_begin <= entry.collection_name_end &&
-                  entry.collection_name_end <= strings.size())) {
-                throw std::runtime_error("index entry has out-of-range collection name begin/end");
-            }
             if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= total)) {
                 throw std::runtime_error("index entry has out-of-range vertex start/count");
             }
-            std::string name(&strings[0] + entry.name_begin, &strings[0] + entry.name_end);
-            std::string collection_name(&strings[0] + entry.collection_name_begin,
-                                        &strings[0] + entry.collection_name_end);
+            std::string name(file.string(strings, entry.name_begin, entry.name_end));
+            std::string collection_name(file.string(strings, entry.collection_name_begin, entry.collection_name_end));
             Mesh mesh;
             mesh.type = GL_TRIANGLES;
             mesh.start = entry.vertex_begin;
@@ -83,6 +90,7 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
                 mesh.min = glm::min(mesh.min, data[v].Position);
                 mesh.max = glm::max(mesh.max, data[v].Position);
             }
+            set_barycentrics(pending_barycentrics, entry.vertex_begin, entry.vertex_end);
             bool inserted = meshes.insert(std::make_pair(name, mesh)).second
                             && collection.insert(std::make_pair(name, collection_name)).second;
             if (!inserted) {
@@ -92,9 +100,10 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
         }
     }
     
-    if (file.peek() != EOF) {
+    if (!file.at_end()) {
         std::cerr << "WARNING: trailing data in mesh file '" << filename << "'" << std::endl;
     }
+
     
     /* //DEBUG:
     std::cout << "File '" << filename << "' contained meshes";
@@ -107,6 +116,78 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
     */
 }
 
+MeshBuffer::MeshBuffer(std::vector< Vertex > &&vertices, std::vector< Mesh > const &ranges, DeferUpload) {
+    owned_vertices = std::move(vertices);
+    GLuint total = GLuint(owned_vertices.size());
+    
+    //keep data for upload():
+    pending.data = reinterpret_cast<char const *>(owned_vertices.data());
+    pending.count = owned_vertices.size() * sizeof(Vertex);
+    
+    set_vertex_attribs();
+    
+    pending_barycentrics.resize(total);
+    set_barycentrics(pending_barycentrics, 0, total);
+    for (Mesh const &range : ranges) {
+        if (!(range.start <= total && range.count <= total - range.start)) {
+            throw std::runtime_error("mesh range is outside of the vertices given");
+        }
+        set_barycentrics(pending_barycentrics, range.start, range.start + range.count);
+    }
+}
+
+void MeshBuffer::set_vertex_attribs() {
+    Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
+    Normal = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Normal));
+    Color = Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), offsetof(Vertex, Color));
+    TexCoord = Attrib(2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, TexCoord));
+    Barycentric = Attrib(3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(glm::u8vec4), 0);
+}
+
+MeshBuffer::~MeshBuffer() {
+    if (buffer != 0) glDeleteBuffers(1, &buffer);
+    if (barycentric_buffer != 0) glDeleteBuffers(1, &barycentric_buffer);
+}
+
+bool MeshBuffer::upload(size_t max_bytes) {
+    if (uploaded()) return true;
+    
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, pending.size(), nullptr, GL_STATIC_DRAW);
+    }
+    size_t count = std::min(max_bytes, pending.size() - pending_uploaded);
+    glBufferSubData(GL_ARRAY_BUFFER, pending_uploaded, count, pending.data + pending_uploaded);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    pending_uploaded += count;
+    if (pending_uploaded < pending.size()) return false;
+    
+    glGenBuffers(1, &barycentric_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, barycentric_buffer);
+    glBufferData(GL_ARRAY_BUFFER, pending_barycentrics.size() * sizeof(glm::u8vec4), pending_barycentrics.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    pending_barycentrics = std::vector<glm::u8vec4>();
+    
+    pending = ChunkSpan<char>();
+    pending_uploaded = 0;
+    pending_file.reset();
+    owned_vertices = std::vector<Vertex>();
+    
+    //(on this thread, since NameIndex isn't thread-safe)
+    register_names();
+    return true;
+}
+
+void MeshBuffer::register_names() {
+    for (auto const &[name, mesh] : meshes) {
+        NameIndex::Id id = NameIndex::get().intern(name);
+        if (by_name_id.size() <= id) by_name_id.resize(id + 1, nullptr);
+        by_name_id[id] = &mesh;
+    }
+}
+
 const Mesh &MeshBuffer::lookup(std::string const &name) const {
     auto f = meshes.find(name);
     if (f == meshes.end()) {
@@ -123,7 +204,10 @@ const std::string &MeshBuffer::lookup_collection(std::string const &name) const
     return f->second;
 }
 
-GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
+GLuint MeshBuffer::make_vao_for_program(GLuint program, GLuint instance_buffer) const {
+    if (!uploaded()) {
+        throw std::runtime_error("Making a vertex array for a MeshBuffer that hasn't been uploaded.");
+    }
     //create a new vertex array object:
     GLuint vao = 0;
     glGenVertexArrays(1, &vao);
@@ -145,6 +229,26 @@ GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
     bind_attribute("Normal", Normal);
     bind_attribute("Color", Color);
     bind_attribute("TexCoord", TexCoord);
+    glBindBuffer(GL_ARRAY_BUFFER, barycentric_buffer);
+    bind_attribute("Barycentric", Barycentric);
+    if (instance_buffer != 0) {
+        //per-instance attributes advance once per instance:
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+        auto bind_instance_attribute = [&](char const *name, GLint columns, GLint rows, size_t offset) {
+            GLint location = glGetAttribLocation(program, name);
+            if (location == -1) return;
+            //(a matrix attribute takes one location per column)
+            for (GLint c = 0; c < columns; ++c) {
+                glVertexAttribPointer(location + c, rows, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                                      (GLbyte *) 0 + offset + c * rows * sizeof(float));
+                glVertexAttribDivisor(location + c, 1);
+                glEnableVertexAttribArray(location + c);
+            }
+            bound.insert(location);
+        };
+        bind_instance_attribute("INSTANCE_TO_WORLD", 4, 3, offsetof(Instance, object_to_world));
+        bind_instance_attribute("INSTANCE_SPECULAR", 1, 4, offsetof(Instance, specular));
+    }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     
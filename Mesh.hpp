@@ -10,10 +10,13 @@
  */
 
 #include "GL.hpp"
+#include "NameIndex.hpp"
+#include "ChunkReader.hpp"
 #include <glm/glm.hpp>
 #include <map>
 #include <limits>
 #include <string>
+#include <vector>
 
 
 struct Mesh {
@@ -34,19 +37,77 @@ struct MeshBuffer {
 	// note: will throw if file fails to read.
 	explicit MeshBuffer(std::string const &filename);
 
+	//construct from a file, but keep the vertex data in memory instead of uploading it:
+	// (makes no OpenGL calls, so it may run on a loading thread; call upload() on the OpenGL thread
+	//  before using the buffer)
+	struct DeferUpload { };
+	MeshBuffer(std::string const &filename, DeferUpload);
+
+	//the vertex format of .pnct files (and of the constructor below):
+	struct Vertex {
+		glm::vec3 Position;
+		glm::vec3 Normal;
+		glm::u8vec4 Color;
+		glm::vec2 TexCoord;
+	};
+	static_assert(sizeof(Vertex) == 3 * 4 + 3 * 4 + 4 * 1 + 2 * 4, "Vertex is packed.");
+
+	//construct from vertices already in memory, divided into (unnamed) triangle ranges, deferred like the above:
+	// (e.g. Scene's static batches)
+	MeshBuffer(std::vector< Vertex > &&vertices, std::vector< Mesh > const &ranges, DeferUpload);
+
+	//upload up to max_bytes more of the vertex data kept by the DeferUpload constructor:
+	// returns true once all of it is in 'buffer' (and mesh names are registered with NameIndex)
+	bool upload(size_t max_bytes = size_t(-1));
+	bool uploaded() const { return pending.data == nullptr && buffer != 0; }
+
+	//the vertex data, while it is still in memory (i.e. until upload() finishes); nullptr afterward:
+	Vertex const *vertices() const { return reinterpret_cast< Vertex const * >(pending.data); }
+
+	//intern mesh names into NameIndex so find() works (upload() does this once it finishes;
+	// tools that never upload can call it directly):
+	void register_names();
+
+	~MeshBuffer();
+	MeshBuffer(MeshBuffer const &) = delete;
+	MeshBuffer &operator=(MeshBuffer const &) = delete;
+
 	//look up a particular mesh by name:
 	// note: will throw if mesh not found.
 	const Mesh &lookup(std::string const &name) const;
     
     const std::string &lookup_collection(std::string const &name) const;
+
+	//look up a mesh by its name's NameIndex id (e.g. from NameIndex::get().tagged(...)):
+	// note: returns nullptr if this buffer has no mesh with that name.
+	const Mesh *find(NameIndex::Id name_id) const {
+		return name_id < by_name_id.size() ? by_name_id[name_id] : nullptr;
+	}
 	
+	//per-instance attributes of instanced draws (see the instanced shader variants), tightly packed in an instance buffer:
+	struct Instance {
+		glm::mat4x3 object_to_world; //INSTANCE_TO_WORLD
+		glm::vec4 specular; //INSTANCE_SPECULAR: brightness in rgb, shininess in a
+	};
+	static_assert(sizeof(Instance) == 16 * 4, "Instance should be packed as 16 floats.");
+
 	//build a vertex array object that links this vbo to attributes to a program:
 	// note: will throw if program defines attributes not contained in this buffer
-	GLuint make_vao_for_program(GLuint program) const;
+	// (if instance_buffer is given, the program's INSTANCE_* attributes come from it, one Instance per instance)
+	GLuint make_vao_for_program(GLuint program, GLuint instance_buffer = 0) const;
 
 	//This is the OpenGL vertex buffer object containing the mesh data:
 	GLuint buffer = 0;
 
+	//Per-vertex barycentric coordinates -- (1,0,0), (0,1,0), (0,0,1) around each triangle -- generated
+	// at load into their own (small) buffer, so wireframes can be drawn by the fragment shader in the same
+	// pass as everything else instead of with glPolygonMode(GL_LINE):
+	GLuint barycentric_buffer = 0;
+	//GLSL for programs that use them; the vertex side pins the "Barycentric" attribute to one location, so
+	// any vertex array works with any such program (e.g. ShadowMapProgram drawing other programs' arrays):
+	static char const *BarycentricVertexGLSL; //declares 'Barycentric' and 'out vec3 barycentric' (copy one to the other)
+	static char const *BarycentricFragmentGLSL; //declares 'in vec3 barycentric' and 'bool offWireframe()'
+
 	//-- internals ---
 
 	//used by the lookup() function:
@@ -54,6 +115,16 @@ struct MeshBuffer {
     
     std::map< std::string, std::string > collection;
 
+	//meshes indexed by the NameIndex id of their name (used by find()):
+	std::vector< Mesh const * > by_name_id;
+
+	//vertex data not yet uploaded (DeferUpload; points into the still-mapped file or owned_vertices), and how much of it has been:
+	std::unique_ptr< ChunkReader > pending_file;
+	std::vector< Vertex > owned_vertices;
+	ChunkSpan< char > pending;
+	size_t pending_uploaded = 0;
+	std::vector< glm::u8vec4 > pending_barycentrics; //(uploaded all at once, with the last of the vertex data)
+
 	//These 'Attrib' structures describe the location of various attributes within the buffer (in exactly format wanted by glVertexAttribPointer). They are set when the file is loaded and are used by the "make_vao_for_program" call:
 	struct Attrib {
 		GLint size = 0;
@@ -71,4 +142,8 @@ struct MeshBuffer {
 	Attrib Normal;
 	Attrib Color;
 	Attrib TexCoord;
+	Attrib Barycentric; //(in barycentric_buffer)
+
+	//set the Attribs above for Vertex data:
+	void set_vertex_attribs();
 };
@@ -11,6 +11,9 @@
 #include "glm/gtc/type_ptr.hpp"
 #include "load_save_png.hpp"
 
+#include <cstddef>
+#include <utility>
+
 MonospaceFont::MonospaceFont(const std::string &filename) {
     glUseProgram(tex_program->program);
     
@@ -90,6 +93,7 @@ MonospaceFont::MonospaceFont(const std::string &filename) {
                 tex_buf,
                 buf,
                 vao,
+                {tex_coords[0], tex_coords[1], tex_coords[2], tex_coords[3]},
         };
         char_info.emplace(cc, character);
     }
@@ -149,3 +153,92 @@ void MonospaceFont::draw(char c, glm::vec2 loc, glm::vec2 size) {
     
     GL_ERRORS();
 }
+
+void MonospaceFont::add_char(TextMesh &mesh, char c, glm::vec2 loc, glm::vec2 size) const {
+    auto f = char_info.find(c);
+    if (f == char_info.end()) f = char_info.find(' ');
+    Character const &character = f->second;
+    
+    // same corners as draw(c, loc, size): the quad spans loc + 2 * size, and draw() additionally
+    // offsets it by loc through OBJECT_TO_CLIP, so that offset is baked in here
+    glm::vec3 corners[4] = {
+            glm::vec3(2 * loc.x, 2 * loc.y, 0.0f),
+            glm::vec3(2 * loc.x + 2 * size.x, 2 * loc.y, 0.0f),
+            glm::vec3(2 * loc.x + 2 * size.x, 2 * loc.y + 2 * size.y, 0.0f),
+            glm::vec3(2 * loc.x, 2 * loc.y + 2 * size.y, 0.0f),
+    };
+    // the fan (0, 1, 2, 3) as two triangles:
+    for (int i: {0, 1, 2, 0, 2, 3}) {
+        mesh.vertices.emplace_back(TextMesh::Vertex{corners[i], character.tex_coords[i]});
+    }
+}
+
+TextMesh::TextMesh(TextMesh &&other) noexcept
+        : vertices(std::move(other.vertices)), vao(other.vao), buf(other.buf), count(other.count) {
+    other.vao = 0;
+    other.buf = 0;
+    other.count = 0;
+}
+
+TextMesh &TextMesh::operator=(TextMesh &&other) noexcept {
+    if (this != &other) {
+        std::swap(vertices, other.vertices);
+        std::swap(vao, other.vao);
+        std::swap(buf, other.buf);
+        std::swap(count, other.count);
+    }
+    return *this;
+}
+
+TextMesh::~TextMesh() {
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    if (buf != 0) glDeleteBuffers(1, &buf);
+}
+
+void MonospaceFont::upload(TextMesh &mesh) const {
+    if (mesh.vao == 0) {
+        glGenVertexArrays(1, &mesh.vao);
+        glGenBuffers(1, &mesh.buf);
+        
+        glBindVertexArray(mesh.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.buf);
+        glVertexAttribPointer(tex_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(TextMesh::Vertex),
+                              (GLbyte *) 0 + offsetof(TextMesh::Vertex, position));
+        glEnableVertexAttribArray(tex_program->Position_vec4);
+        glVertexAttribPointer(tex_program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(TextMesh::Vertex),
+                              (GLbyte *) 0 + offsetof(TextMesh::Vertex, tex_coord));
+        glEnableVertexAttribArray(tex_program->TexCoord_vec2);
+        glBindVertexArray(0);
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.buf);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(TextMesh::Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mesh.count = GLsizei(mesh.vertices.size());
+    
+    GL_ERRORS();
+}
+
+void MonospaceFont::draw(TextMesh const &mesh) const {
+    if (mesh.count == 0) return;
+    
+    glUseProgram(tex_program->program);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    glBindVertexArray(mesh.vao);
+    glUniformMatrix4fv(tex_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    glUniform4f(tex_program->COLOR_vec4, 1, 1, 1, 1);
+    
+    glDrawArrays(GL_TRIANGLES, 0, mesh.count);
+    
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    
+    GL_ERRORS();
+}
@@ -12,6 +12,7 @@
 #include <cassert>
 #include <glm/glm.hpp>
 #include <map>
+#include <vector>
 
 #include "data_path.hpp"
 #include "read_write_chunk.hpp"
@@ -27,6 +28,35 @@ struct Character {
     // the following don't actually have information and are recalculated every use
     GLuint buf;
     GLuint vao;
+    // same as the contents of tex_buf, for building TextMeshes
+    glm::vec2 tex_coords[4];
+};
+
+/*
+ * Many characters' quads in one buffer, so a block of text can be uploaded once
+ * and drawn with a single call until it changes
+ */
+struct TextMesh {
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec2 tex_coord;
+    };
+    
+    std::vector<Vertex> vertices;
+    
+    GLuint vao = 0;
+    GLuint buf = 0;
+    GLsizei count = 0; // vertices in buf
+    
+    TextMesh() = default;
+    
+    /* owns vao and buf (deleted with the mesh), so it can be moved but not copied */
+    TextMesh(TextMesh &&other) noexcept;
+    TextMesh &operator=(TextMesh &&other) noexcept;
+    TextMesh(TextMesh const &) = delete;
+    TextMesh &operator=(TextMesh const &) = delete;
+    
+    ~TextMesh();
 };
 
 struct MonospaceFont {
@@ -36,6 +66,15 @@ struct MonospaceFont {
     explicit MonospaceFont(const std::string &filename);
     
     void draw(char c, glm::vec2 loc, glm::vec2 size);
+    
+    /* append the quad that draw(c, loc, size) would draw to mesh.vertices */
+    void add_char(TextMesh &mesh, char c, glm::vec2 loc, glm::vec2 size) const;
+    
+    /* upload mesh.vertices to the GPU (creating its buffers on first use) */
+    void upload(TextMesh &mesh) const;
+    
+    /* draw the last upload()ed contents of mesh */
+    void draw(TextMesh const &mesh) const;
 };
 
 
@@ -0,0 +1,51 @@
+#include "NameIndex.hpp"
+
+#include <stdexcept>
+
+NameIndex &NameIndex::get() {
+	static NameIndex index;
+	return index;
+}
+
+NameIndex::Id NameIndex::intern(std::string const &name) {
+	auto ret = ids.emplace(name, Id(names.size()));
+	if (!ret.second) return ret.first->second;
+
+	Id id = ret.first->second;
+	names.emplace_back(&ret.first->first);
+	uint64_t mask = 0;
+	for (Tag t = 0; t < substrings.size(); ++t) {
+		if (name.find(substrings[t]) != std::string::npos) {
+			mask |= uint64_t(1) << t;
+			members[t].emplace_back(id); //(new ids are the largest, so this stays sorted)
+		}
+	}
+	masks.emplace_back(mask);
+	return id;
+}
+
+NameIndex::Id NameIndex::find(std::string const &name) const {
+	auto f = ids.find(name);
+	return f == ids.end() ? Invalid : f->second;
+}
+
+NameIndex::Tag NameIndex::tag(std::string const &substring) {
+	auto f = tags.find(substring);
+	if (f != tags.end()) return f->second;
+
+	if (substrings.size() >= MaxTags) {
+		throw std::runtime_error("NameIndex: more than " + std::to_string(MaxTags) + " tags (registering '" + substring + "').");
+	}
+	Tag t = Tag(substrings.size());
+	tags.emplace(substring, t);
+	substrings.emplace_back(substring);
+	members.emplace_back();
+
+	for (Id id = 0; id < names.size(); ++id) {
+		if (names[id]->find(substring) != std::string::npos) {
+			masks[id] |= uint64_t(1) << t;
+			members[t].emplace_back(id);
+		}
+	}
+	return t;
+}
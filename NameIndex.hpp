@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+ * Interned object names plus a tag index over them.
+ *
+ * Scene objects are classified by naming convention ("col_", "text_", "bread_", "_pass", ...).
+ * Instead of searching every name for every convention, names are interned once (at load time)
+ * into small integer ids, and each substring "tag" keeps the sorted list of ids whose names
+ * contain it and sets a bit in each of those names' tag masks:
+ *  - tagged(tag) lists the matching names, so setup loops only visit matching objects
+ *  - has(id, tag) is a bit test, for classifying objects at runtime
+ *
+ * Registering a tag scans the names interned so far once; names interned later are tested
+ * against the registered tags as they come in.
+ *
+ * There is one table for the whole program (NameIndex::get()); it is not thread-safe.
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct NameIndex {
+	typedef uint32_t Id;
+	static constexpr Id Invalid = -1U;
+
+	typedef uint32_t Tag;
+	static constexpr uint32_t MaxTags = 64;
+
+	static NameIndex &get();
+
+	//id of name, interning it if it is new:
+	Id intern(std::string const &name);
+
+	//id of name, or Invalid if it was never interned:
+	Id find(std::string const &name) const;
+
+	std::string const &name(Id id) const { return *names[id]; }
+
+	size_t size() const { return names.size(); }
+
+	//tag for all names containing 'substring' (registering it if it is new):
+	// throws if more than MaxTags different substrings are used
+	Tag tag(std::string const &substring);
+
+	//ids (in increasing order) of names containing the tag's substring:
+	std::vector< Id > const &tagged(Tag tag) const { return members[tag]; }
+
+	//does the name with this id contain the tag's substring?
+	bool has(Id id, Tag tag) const { return id != Invalid && ((masks[id] >> tag) & 1); }
+
+private:
+	std::unordered_map< std::string, Id > ids;
+	std::vector< std::string const * > names; //points at the keys of 'ids'
+	std::vector< uint64_t > masks; //bit t set if names[id] contains substrings[t]
+
+	std::unordered_map< std::string, Tag > tags;
+	std::vector< std::string > substrings;
+	std::vector< std::vector< Id > > members;
+};
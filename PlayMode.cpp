@@ -18,17 +18,24 @@
 #include "spline.h"
 #include "TexProgram.hpp"
 #include "load_save_png.hpp"
+#include "NameIndex.hpp"
+#include "LevelStreamer.hpp"
+#include "UniformBlocks.hpp"
+#include "EdgeDetectProgram.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <utility>
 
-GLuint artworld_meshes_for_lit_color_texture_program = 0;
-GLuint artworld_meshes_for_rocket_color_texture_program = 0;
-GLuint foodworld_meshes_for_lit_color_texture_program = 0;
-GLuint foodworld_meshes_for_rocket_color_texture_program = 0;
-GLuint textcube_meshes_for_lit_color_texture_program = 0;
+//the paintbrush can be picked up from any collider check (see NameIndex):
+static NameIndex::Tag paintbrush_tag() {
+    static NameIndex::Tag const tag = NameIndex::get().tag("Paintbrush");
+    return tag;
+}
+
 GLuint wizard_meshes_for_lit_color_texture_program = 0;
 GLuint image_vao = 0;
 
@@ -77,55 +84,6 @@ Load< Sound::Sample > walk_15x_sample(LoadTagDefault, []() -> Sound::Sample cons
 
 
 
-Load<MeshBuffer> artworld_meshes(LoadTagDefault, []() -> MeshBuffer const * {
-    MeshBuffer const *ret = new MeshBuffer(data_path("artworld.pnct"));
-    artworld_meshes_for_lit_color_texture_program = ret->make_vao_for_program(lit_color_texture_program->program);
-    artworld_meshes_for_rocket_color_texture_program = ret->make_vao_for_program(rocket_color_texture_program->program);
-    
-    // register text bearers and their cameras
-    for (const auto &[name, mesh]: ret->meshes) {
-        if (name.rfind("text_", 0) != std::string::npos) {
-            std::cout << "Found sign: " << name << std::endl;
-            if (!endsWith(name, "_m")) {
-                std::cerr << "Sign mesh " << name << " doesn't end in _m" << std::endl;
-            } else {
-                textBearers[name] = &mesh;
-                std::string camname = name;
-                camname.back() = 'c';
-                textBearerCams[name] = camname;
-            }
-        }
-    }
-    
-    return ret;
-});
-
-
-Load<MeshBuffer> foodworld_meshes(LoadTagDefault,[]() -> MeshBuffer const * {
-    MeshBuffer const *ret = new MeshBuffer(data_path("foodworld.pnct"));
-    foodworld_meshes_for_lit_color_texture_program = ret->make_vao_for_program(lit_color_texture_program->program);
-    foodworld_meshes_for_rocket_color_texture_program = ret->make_vao_for_program(rocket_color_texture_program->program);
-
-    // register text bearers and their cameras
-    for (const auto &[name, mesh] : ret->meshes) {
-      if (name.rfind("text_", 0) != std::string::npos) {
-std::cout << "Found sign: " << name << std::endl;
-        if (!endsWith(name, "_m")) {
-          std::cerr << "Sign mesh " << name << " doesn't end in _m" << std::endl;
-        } else {
-          textBearers[name] = &mesh;
-          std::string camname = name;
-          camname.back() = 'c';
-          textBearerCams[name] = camname;
-        }
-      }
-    }
-
-    return ret;
-});
-
-
-
 Load<MeshBuffer> wizard_meshes(LoadTagDefault, []() -> MeshBuffer const * {
     MeshBuffer const *ret = new MeshBuffer(data_path("wizard.pnct"));
     wizard_meshes_for_lit_color_texture_program = ret->make_vao_for_program(rocket_color_texture_program->program);
@@ -137,100 +95,119 @@ Load<TextStorage> text_storage(LoadTagDefault, []() -> TextStorage const * {
     return ret;
 });
 
-Load<Scene> artworld_scene(LoadTagDefault, []() -> Scene const * {
-    return new Scene(
-            data_path("artworld.scene"),
-            [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name) {
-                // keep transforms available
-                nameToTransform[mesh_name] = transform;
-                
-                if (mesh_name == "Player")
-                    return;
-                
-                Mesh const &mesh = artworld_meshes->lookup(mesh_name);
-                
-                scene.drawables.emplace_back(std::make_shared<Scene::Drawable>(transform));
-                std::shared_ptr<Scene::Drawable> &drawable = scene.drawables.back();
-                
-                if (artworld_meshes->lookup_collection(mesh_name) == "Rocket") {
-                    drawable->pipeline = rocket_color_texture_program_pipeline;
-                    drawable->pipeline.vao = artworld_meshes_for_rocket_color_texture_program;
-                    drawable->specular_info.shininess = 10.0;
-                    drawable->specular_info.specular_brightness = glm::vec3(1.0f, 0.9f, 0.7f);
-                } else {
-                    drawable->pipeline = lit_color_texture_program_pipeline;
-                    drawable->pipeline.vao = artworld_meshes_for_lit_color_texture_program;
-                    drawable->specular_info.shininess = 10.0;
-                }
-                
-                drawable->pipeline.type = mesh.type;
-                drawable->pipeline.start = mesh.start;
-                drawable->pipeline.count = mesh.count;
-                drawable->wireframe_info.draw_frame = false;
-                drawable->wireframe_info.one_time_change = false;
-                drawable->scene_info.type = ARTSCENE;
-            });
-});
-
+WalkMesh const *walkmesh = nullptr;
 
+//--- levels (streamed in by PlayMode::levels) ---
 
-Load<Scene> foodworld_scene(LoadTagDefault,[]() -> Scene const * {
-    return new Scene(
-            data_path("foodworld.scene"),
-            [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name) {
-                // keep transforms available
-                nameToTransform[mesh_name] = transform;
+//set up a drawable for each mesh in a level's scene (runs on the loading thread):
+static void add_level_drawable(LevelStreamer::Level &level, Scene::Transform *transform, std::string const &mesh_name, scene_type type) {
+    if (mesh_name == "Player")
+        return;
+    
+    Mesh const &mesh = level.meshes->lookup(mesh_name);
+    std::string const &collection = level.meshes->lookup_collection(mesh_name);
+    
+    level.scene->drawables.emplace_back(std::make_shared<Scene::Drawable>(transform));
+    std::shared_ptr<Scene::Drawable> &drawable = level.scene->drawables.back();
+    
+    //(vertex arrays are attached in attach_level_vaos, once the meshes are uploaded)
+    if (type == ARTSCENE) {
+        if (collection == "Rocket") {
+            drawable->pipeline = rocket_color_texture_program_pipeline;
+            drawable->specular_info.shininess = 10.0;
+            drawable->specular_info.specular_brightness = glm::vec3(1.0f, 0.9f, 0.7f);
+        } else {
+            drawable->pipeline = lit_color_texture_program_pipeline;
+            drawable->specular_info.shininess = 10.0;
+        }
+    } else {
+        if (collection == "Rocket") {
+            drawable->pipeline = rocket_color_texture_program_pipeline;
+            drawable->specular_info.shininess = 10.0;
+        } else if (collection == "bg_noshadow") {
+            drawable->pipeline = shadow_program_pipeline;
+            drawable->specular_info.shininess = 5.0;
+            drawable->specular_info.specular_brightness = glm::vec3(0.5f, 0.5f, 0.5f);
+            drawable->ignore_shadow = true;
+        } else {
+            drawable->pipeline = shadow_program_pipeline;
+            drawable->specular_info.shininess = 10.0;
+        }
+    }
+    
+    drawable->pipeline.write().type = mesh.type;
+    drawable->pipeline.write().start = mesh.start;
+    drawable->pipeline.write().count = mesh.count;
+    drawable->bounds_min = mesh.min;
+    drawable->bounds_max = mesh.max;
+    drawable->wireframe_info.draw_frame = false;
+    drawable->wireframe_info.one_time_change = false;
+    drawable->scene_info.type = type;
+}
 
-                if (mesh_name == "Player")
-                    return;
-                
-                Mesh const &mesh = foodworld_meshes->lookup(mesh_name);
-                
-                scene.drawables.emplace_back(std::make_shared<Scene::Drawable>(transform));
-                std::shared_ptr<Scene::Drawable> &drawable = scene.drawables.back();
-                
-                if (foodworld_meshes->lookup_collection(mesh_name) == "Rocket") {
-                    //drawable->pipeline = lit_color_texture_program_pipeline;
-                    //drawable->pipeline.vao = artworld_meshes_for_lit_color_texture_program;
-                    drawable->pipeline = rocket_color_texture_program_pipeline;
-                    drawable->pipeline.vao = foodworld_meshes_for_rocket_color_texture_program;
-                    drawable->specular_info.shininess = 10.0;
-                } else if (foodworld_meshes->lookup_collection(mesh_name) == "bg_noshadow") {
-                    drawable->pipeline = shadow_program_pipeline;
-                    drawable->pipeline.vao = foodworld_meshes_for_lit_color_texture_program;
-                    drawable->specular_info.shininess = 5.0;
-                    drawable->specular_info.specular_brightness = glm::vec3(0.5f, 0.5f, 0.5f);
-                    drawable->ignore_shadow = true;
-                } else {
-                    drawable->pipeline = shadow_program_pipeline;
-                    drawable->pipeline.vao = foodworld_meshes_for_lit_color_texture_program;
-                    drawable->specular_info.shininess = 10.0;
-                }
-                
-                drawable->pipeline.type = mesh.type;
-                drawable->pipeline.start = mesh.start;
-                drawable->pipeline.count = mesh.count;
-                drawable->wireframe_info.draw_frame = false;
-                drawable->wireframe_info.one_time_change = false;
-                drawable->scene_info.type = FOODSCENE;
-            });
-});
+//make a level's vertex arrays and point its drawables at them (runs on the OpenGL thread):
+static void attach_level_vaos(LevelStreamer::Level &level) {
+    GLuint lit = level.meshes->make_vao_for_program(lit_color_texture_program->program);
+    GLuint rocket = level.meshes->make_vao_for_program(rocket_color_texture_program->program);
+    level.vaos["lit"] = lit;
+    level.vaos["rocket"] = rocket;
+    
+    //vertex arrays for the instanced variants also read per-instance data from Scene::instance_buffer():
+    std::unordered_map<GLuint, GLuint> instanced_vaos;
+    for (auto const &[name, program]: {
+            std::make_pair("lit_instanced", lit_color_texture_program_instanced->program),
+            std::make_pair("shadow_instanced", shadow_program_instanced->program),
+            std::make_pair("rocket_instanced", rocket_color_texture_program_instanced->program)}) {
+        GLuint vao = level.meshes->make_vao_for_program(program, Scene::instance_buffer());
+        level.vaos[name] = vao;
+        instanced_vaos[program] = vao;
+    }
+    
+    for (auto &drawable: level.scene->drawables) {
+        Scene::Drawable::Pipeline &pipeline = drawable->pipeline.write();
+        pipeline.vao = (pipeline.program == rocket_color_texture_program->program ? rocket : lit);
+        auto found = instanced_vaos.find(pipeline.instanced.program);
+        pipeline.instanced.vao = (found != instanced_vaos.end() ? found->second : 0);
+    }
+}
 
-WalkMesh const *walkmesh = nullptr;
-WalkMesh const *artworld_walkmesh = nullptr;
-Load<WalkMeshes> artworld_walkmeshes(LoadTagDefault, []() -> WalkMeshes const * {
-    auto *ret = new WalkMeshes(data_path("artworld.w"));
-    artworld_walkmesh = &ret->lookup("WalkMesh");
-    return ret;
-});
+static std::string level_name(scene_type type) {
+    return type == ARTSCENE ? "artworld" : "foodworld";
+}
 
-WalkMesh const *foodworld_walkmesh = nullptr;
-Load<WalkMeshes> foodworld_walkmeshes(LoadTagDefault, []() -> WalkMeshes const * {
-    auto *ret = new WalkMeshes(data_path("foodworld.w"));
-    foodworld_walkmesh = &ret->lookup("WalkMesh");
-    return ret;
-});
+static LevelStreamer::Desc level_desc(scene_type type) {
+    std::string name = level_name(type);
+    LevelStreamer::Desc desc;
+    desc.meshes_file = data_path(name + ".pnct");
+    desc.scene_file = data_path(name + ".scene");
+    desc.walkmeshes_file = data_path(name + ".w");
+    desc.baked_file = data_path(name + ".baked");
+    desc.on_drawable = [type](LevelStreamer::Level &level, Scene::Transform *transform, std::string const &mesh_name) {
+        add_level_drawable(level, transform, mesh_name, type);
+    };
+    desc.on_uploaded = attach_level_vaos;
+    return desc;
+}
 
+//point the sign-reading lookups (nameToTransform, textBearers, textBearerCams) at a level:
+static void register_text_bearers(LevelStreamer::Level const &level) {
+    nameToTransform = level.mesh_transforms;
+    textBearers.clear();
+    textBearerCams.clear();
+    for (const auto &[name, mesh]: level.meshes->meshes) {
+        if (name.rfind("text_", 0) != std::string::npos) {
+            std::cout << "Found sign: " << name << std::endl;
+            if (!endsWith(name, "_m")) {
+                std::cerr << "Sign mesh " << name << " doesn't end in _m" << std::endl;
+            } else {
+                textBearers[name] = &mesh;
+                std::string camname = name;
+                camname.back() = 'c';
+                textBearerCams[name] = camname;
+            }
+        }
+    }
+}
 PlayMode::PlayMode(SDL_Window *window)
         : sign_display(8, 40, glm::vec2(-0.3f,-0.25f), glm::vec2(0.6f,0.4f),"UbuntuMono_transparent_white.png"),
           text_display(5, 60, glm::vec2(-0.40f, -0.45f), glm::vec2(0.8f, 0.2f)),
@@ -284,12 +261,18 @@ PlayMode::PlayMode(SDL_Window *window)
     }
 
 
-    initialize_scene(artworld_scene,artworld_meshes,ARTSCENE);
-    initialize_scene(foodworld_scene,foodworld_meshes,FOODSCENE);
+    //only the first level is loaded up front; the next one streams in while playing:
+    levels.add(level_name(ARTSCENE), level_desc(ARTSCENE));
+    levels.add(level_name(FOODSCENE), level_desc(FOODSCENE));
+    LevelStreamer::Level &first_level = levels.finish(level_name(ARTSCENE));
+    initialize_scene(first_level, ARTSCENE);
+    register_text_bearers(first_level);
+    levels.request(level_name(FOODSCENE));
 
 
     scene = scene_map[ARTSCENE];
-    walkmesh = artworld_walkmesh;
+    current_scene = ARTSCENE;
+    walkmesh = &first_level.walkmeshes->lookup("WalkMesh");
     bgm = Sound::loop(*olas_sample);
     
     initialize_player();
@@ -304,7 +287,33 @@ PlayMode::PlayMode(SDL_Window *window)
     walk->set_volume(0.0f);
     walk_15x->set_volume(0.0f);
 
-
+    //update systems, in the order they ran before being split up; each declares the data it really touches
+    // (make_local_to_world() refreshes cached matrices, so calling it counts as writing Scene::Transform):
+    // -> wave 0: sign_reading, footsteps, reset_button_downs; then camera_animation, player_movement, player_collider
+    update_scheduler.add_system("sign_reading",
+            Scheduler::Access().reads<Button, Player, Scene::Camera>().writes<CameraAnimation, Scene::Transform>(),
+            [this](float) { update_sign_reading(); });
+    update_scheduler.add_system("footsteps",
+            Scheduler::Access().reads<Button, Player>().writes<Sound::PlayingSample>(),
+            [this](float) { update_footsteps(); });
+    update_scheduler.add_system("reset_button_downs",
+            Scheduler::Access().writes<ButtonDowns>(),
+            [this](float) { reset_button_downs(); });
+    update_scheduler.add_system("camera_animation",
+            //(de)activating text displays adds/removes Draw components:
+            Scheduler::Access().reads<Button, Player, Scene::Camera, Scene::Collider>().writes<CameraAnimation, Scene::Transform, TextDisplay>().on_main_thread(),
+            [this](float elapsed) { update_camera_animation(elapsed); });
+    update_scheduler.add_system("player_movement",
+            Scheduler::Access().reads<Button, Scene::Collider, WalkMesh>().writes<Player, Scene::Transform, Sound::PlayingSample>(),
+            [this](float elapsed) { update_player_movement(elapsed); });
+    update_scheduler.add_system("player_collider",
+            Scheduler::Access().reads<Player>().writes<Scene::Transform, Scene::Collider>(),
+            [this](float) { update_player_collider(); });
+
+    //set MAGITECH_SYSTEM_TIMINGS to print where update() time goes every few seconds:
+    if (std::getenv("MAGITECH_SYSTEM_TIMINGS")) update_scheduler.report_interval = 5.0f;
+    //..and MAGITECH_PASS_TIMINGS for where draw() time goes (see frame_graph in draw()):
+    if (std::getenv("MAGITECH_PASS_TIMINGS")) frame_graph.report_interval = 5.0f;
 }
 
 PlayMode::~PlayMode() = default;
@@ -314,6 +323,25 @@ bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 }
 
 void PlayMode::update(float elapsed) {
+    //streamed levels: upload a slice, set up levels that just finished, and switch when ready:
+    levels.update();
+    for (scene_type type: {ARTSCENE, FOODSCENE}) {
+        if (!scene_map.count(type)) {
+            if (LevelStreamer::Level *level = levels.get(level_name(type))) {
+                initialize_scene(*level, type);
+            }
+        }
+    }
+    if (next_scene != current_scene && scene_map.count(next_scene)) {
+        change_scene(next_scene);
+    }
+    
+    update_scheduler.run(elapsed);
+    //one pass over the hierarchy, so draw()'s passes only look up cached world matrices:
+    scene->update_transforms();
+}
+
+void PlayMode::update_sign_reading() {
     if (animated == NO && read.pressed && animationTime == 0.0) {
         //float distance = std::numeric_limits<float>::max();
         float distance = player.SIGHT_DISTANCE; // can see this far
@@ -369,6 +397,9 @@ void PlayMode::update(float elapsed) {
             std::cout << "No readable sign in range" << std::endl;
         }
     }
+}
+
+void PlayMode::update_camera_animation(float elapsed) {
     // camera animation
     if (animated == TO || animated == FROM) {
         animationTime += elapsed;
@@ -384,7 +415,9 @@ void PlayMode::update(float elapsed) {
                 float distance = 0.0;
                 std::tie(c, distance) = mouse_text_check("text_", true);
                 if (c) {
-                    if (c->name.find("text_sign_")!=std::string::npos){
+                    static NameIndex::Tag const sign_tag = NameIndex::get().tag("text_sign_");
+                    static NameIndex::Tag const npc_tag = NameIndex::get().tag("text_col_npc_");
+                    if (c->has_tag(sign_tag)){
                         if (text_storage->object_text_map.count(c->name)) {
                             auto v = text_storage->object_text_map.at(c->name);
                             sign_display.text = {""};
@@ -392,7 +425,7 @@ void PlayMode::update(float elapsed) {
                             sign_display.activate();
                         }
                     }
-                    else if(c->name.find("text_col_npc_")!=std::string::npos){
+                    else if(c->has_tag(npc_tag)){
                         if (text_storage->object_text_map.count(c->name)) {
                             auto v = text_storage->object_text_map.at(c->name);
                             text_display.text = {""};
@@ -430,7 +463,9 @@ void PlayMode::update(float elapsed) {
         text_display.deactivate();
         text_display.remove_all_text();
     }
-    
+}
+
+void PlayMode::update_player_movement(float elapsed) {
     //player walking:
     {
         if(player.on_walkmesh){
@@ -446,17 +481,6 @@ void PlayMode::update(float elapsed) {
             if (move != glm::vec2(0.0f))
             {
                 move = glm::normalize(move) * PlayerSpeed * elapsed;
-                if (lrun.pressed || rrun.pressed) {
-                    walk->set_volume(0.0f);
-                    walk_15x->set_volume(1.0f);
-                } else {
-                    walk->set_volume(1.0f);
-                    walk_15x->set_volume(0.0f);
-                }
-
-            } else {
-                walk->set_volume(0.0f);
-                walk_15x->set_volume(0.0f);
             }
 
             if (lrun.pressed || rrun.pressed)
@@ -600,10 +624,33 @@ void PlayMode::update(float elapsed) {
         }
         
     }
-    
+}
+
+void PlayMode::update_footsteps() {
+    //walking sounds follow the same inputs as update_player_movement's walking:
+    if (!player.on_walkmesh) return;
+    bool moving = (left.pressed && !right.pressed) || (!left.pressed && right.pressed)
+            || (down.pressed && !up.pressed) || (!down.pressed && up.pressed);
+    if (moving) {
+        if (lrun.pressed || rrun.pressed) {
+            walk->set_volume(0.0f);
+            walk_15x->set_volume(1.0f);
+        } else {
+            walk->set_volume(1.0f);
+            walk_15x->set_volume(0.0f);
+        }
+    } else {
+        walk->set_volume(0.0f);
+        walk_15x->set_volume(0.0f);
+    }
+}
+
+void PlayMode::update_player_collider() {
     auto bbox = scene->collider_name_map[player.name];
     bbox->update_BBox(player.transform);
-    
+}
+
+void PlayMode::reset_button_downs() {
     //reset button press counters:
     left.downs = 0;
     right.downs = 0;
@@ -635,13 +682,16 @@ void PlayMode::resize_depth_tex() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glBindTexture(GL_TEXTURE_2D, 0);
     
-    glBindTexture(GL_TEXTURE_2D, shadow_depth_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, (GLsizei)(window_size.x * 4.0), (GLsizei)(window_size.y * 4.0), 0, GL_DEPTH_COMPONENT,
-                 GL_UNSIGNED_INT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    //outline weights (unclamped, hence float) from the edge-detection passes:
+    for (GLuint tex : {edge_tmp_tex, edge_tex}) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, (GLsizei)window_size.x, (GLsizei)window_size.y, 0, GL_RED,
+                     GL_HALF_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -690,9 +740,10 @@ void PlayMode::gen_framebuffers() {
     glBindFramebuffer(GL_FRAMEBUFFER, depth_fb);
     glGenTextures(1, &depth_tex);
     
-    glGenFramebuffers(1, &shadow_depth_fb);
-    glBindFramebuffer(GL_FRAMEBUFFER, shadow_depth_fb);
-    glGenTextures(1, &shadow_depth_tex);
+    glGenFramebuffers(1, &edge_tmp_fb);
+    glGenTextures(1, &edge_tmp_tex);
+    glGenFramebuffers(1, &edge_fb);
+    glGenTextures(1, &edge_tex);
     
     resize_depth_tex();
     
@@ -700,9 +751,35 @@ void PlayMode::gen_framebuffers() {
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_tex, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     
-    glBindFramebuffer(GL_FRAMEBUFFER, shadow_depth_fb);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadow_depth_tex, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, edge_tmp_fb);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, edge_tmp_tex, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, edge_fb);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, edge_tex, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    //shadow maps don't depend on the window size, so they're sized once, here:
+    if (char const *size = std::getenv("MAGITECH_SHADOW_MAP_SIZE")) {
+        shadow_map_size = std::max(1, std::atoi(size));
+    }
+    auto gen_shadow_map = [this](GLuint *fb, GLuint *tex) {
+        glGenFramebuffers(1, fb);
+        glGenTextures(1, tex);
+        glBindTexture(GL_TEXTURE_2D, *tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadow_map_size, shadow_map_size, 0, GL_DEPTH_COMPONENT,
+                     GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, *fb);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *tex, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    };
+    gen_shadow_map(&shadow_depth_fb, &shadow_depth_tex);
+    gen_shadow_map(&static_shadow_fb, &static_shadow_tex);
+    
+    GL_ERRORS();
 }
 
 // Draw an R sign as a hint to the player
@@ -926,7 +1003,7 @@ void PlayMode::draw_black_screen(){
     end_timepoint = std::chrono::system_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_timepoint - start_timepoint);
 
-    if (duration.count() > 3){
+    if (duration.count() > 3 && next_scene == current_scene){
         is_changing_scene = false;
         text_display.deactivate();
         text_display.remove_all_text();
@@ -947,75 +1024,96 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
     //update camera aspect ratio for drawable:
     player.camera->aspect = float(drawable_size.x) / float(drawable_size.y);
     
-    //set up light type and position for lit_color_texture_program:
+    //per-frame constants for every scene program (lights are set up with the programs, and the
+    // camera by Scene::draw):
     // TODO: consider using the Light(s) in the scene to do this
-    glUseProgram(lit_color_texture_program->program);
-    glUniform1i(lit_color_texture_program->LIGHT_TYPE_int, 1);
-    glUniform3fv(lit_color_texture_program->LIGHT_DIRECTION_vec3, 1,
-                 glm::value_ptr(glm::normalize(glm::vec3(0.5f, 1.0f, -1.0f))));
-    glUniform3fv(lit_color_texture_program->LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(0.85f, 0.85f, 0.85f)));
-    glUniform3fv(lit_color_texture_program->AMBIENT_LIGHT_ENERGY_vec3, 1,
-                 glm::value_ptr(glm::vec3(0.25f, 0.25f, 0.25f)));
-    
     int w, h;
     int wn, hn;
     SDL_GL_GetDrawableSize(window, &w, &h);
     SDL_GetWindowSize(window, &wn, &hn);
-    glm::vec4 window_size = glm::vec4(w, h, wn, hn);
-    glUniform4fv(lit_color_texture_program->WINDOW_DIMENSIONS, 1, glm::value_ptr(window_size));
-    glUseProgram(0);
-    
-    glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
-    glClearDepth(1.0f); //1.0 is actually the default value to clear the depth buffer to, but FYI you can change it.
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    UniformBlocks::Frame frame;
+    frame.WINDOW_DIMENSIONS = glm::vec4(w, h, wn, hn);
+    UniformBlocks::set_frame(frame);
     
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS); //this is the default depth comparison function, but FYI you can change it.
+    glClearDepth(1.0f); //1.0 is actually the default value to clear the depth buffer to, but FYI you can change it.
     
-    
-    // Draw the depth framebuffer for edge detection
-    glBindFramebuffer(GL_FRAMEBUFFER, depth_fb);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    scene->draw(*player.camera, false);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    scene->draw(*player.camera, true);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    
+    //the frame's passes, over the resources they read / write / clear; frame_graph drops any pass
+    // whose results go unused, and times the rest (set MAGITECH_PASS_TIMINGS to print the timings):
+    frame_graph.clear();
+
+    //cull once per view; every pass from that view reuses the list:
+    frame_graph.add_pass("cull_camera", FrameGraph::Access().clears("camera_visible"), [&](){
+        scene->cull(player.camera->make_world_to_clip(), camera_visible);
+    });
+    frame_graph.add_pass("cull_light", FrameGraph::Access().clears("light_visible"), [&](){
+        scene->cull(glm::mat4(Scene::default_world_to_light()), light_visible, Scene::DynamicDrawables);
+    });
+
     // Draw the depth framebuffer for edge detection
-    glBindFramebuffer(GL_FRAMEBUFFER, depth_fb);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    scene->draw(*player.camera, false);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    scene->draw(*player.camera, true);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depth_tex);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, dot_tex);
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, shadow_depth_tex);
-    glActiveTexture(GL_TEXTURE0);
-
-    glViewport(0, 0, (GLsizei)(drawable_size.x * 4.0), (GLsizei)(drawable_size.y * 4.0));
-    glBindFramebuffer(GL_FRAMEBUFFER, shadow_depth_fb);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    scene->draw_shadow(*player.camera, false);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    scene->draw_shadow(*player.camera, true);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    glViewport(0, 0, drawable_size.x, drawable_size.y);
+    frame_graph.add_pass("depth", FrameGraph::Access().reads("camera_visible").clears("depth"), [&](){
+        glViewport(0, 0, drawable_size.x, drawable_size.y);
+        glBindFramebuffer(GL_FRAMEBUFFER, depth_fb);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        scene->draw(*player.camera, &camera_visible);
+    });
+
+    //..which becomes ComicBookProgram's outline mask, once per pixel (two 1D passes, see EdgeDetectProgram):
+    frame_graph.add_pass("edges", FrameGraph::Access().reads("depth").clears("edge_mask"), [&](){
+        glViewport(0, 0, drawable_size.x, drawable_size.y);
+        glBindFramebuffer(GL_FRAMEBUFFER, edge_tmp_fb);
+        edge_detect_horizontal_program->draw(depth_tex);
+        glBindFramebuffer(GL_FRAMEBUFFER, edge_fb);
+        edge_detect_vertical_program->draw(edge_tmp_tex);
+    });
+
+    //the static casters' shadows are drawn once and kept until one of them changes (the light is fixed):
+    // while the kept map is current, the pass produces nothing this frame needs, so the graph drops it
+    uint64_t signature = scene->static_shadow_signature();
+    FrameGraph::Access static_shadow_access;
+    if (!static_shadow_valid || signature != static_shadow_signature) static_shadow_access.clears("static_shadow_map");
+    frame_graph.add_pass("static_shadow", static_shadow_access, [&](){
+        scene->cull(glm::mat4(Scene::default_world_to_light()), static_light_visible, Scene::StaticDrawables);
+        glViewport(0, 0, shadow_map_size, shadow_map_size);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_shadow_fb);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        scene->draw_shadow(*player.camera, &static_light_visible);
+        static_shadow_valid = true;
+        static_shadow_signature = signature;
+    });
+
+    //..and each frame the dynamic casters go on top of a copy of them:
+    frame_graph.add_pass("shadow", FrameGraph::Access().reads("static_shadow_map").reads("light_visible").clears("shadow_map"), [&](){
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, static_shadow_fb);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadow_depth_fb);
+        glBlitFramebuffer(0, 0, shadow_map_size, shadow_map_size, 0, 0, shadow_map_size, shadow_map_size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, shadow_depth_fb);
+        glViewport(0, 0, shadow_map_size, shadow_map_size);
+        scene->draw_shadow(*player.camera, &light_visible);
+    });
+
     // Draw the world
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    scene->draw(*player.camera, false);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    scene->draw(*player.camera, true);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    // (only the art scene draws with ComicBookProgram -- see add_level_drawable -- so elsewhere nothing
+    //  reads the outline mask, and the depth and edge passes get dropped)
+    FrameGraph::Access color_access = FrameGraph::Access().reads("camera_visible").reads("shadow_map").clears("backbuffer");
+    if (current_scene == ARTSCENE) color_access.reads("edge_mask");
+    frame_graph.add_pass("color", color_access, [&](){
+        glViewport(0, 0, drawable_size.x, drawable_size.y);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, edge_tex);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, dot_tex);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, shadow_depth_tex);
+        glActiveTexture(GL_TEXTURE0);
+
+        scene->draw(*player.camera, &camera_visible);
+    });
     
     // {
     //     DrawLines lines(player.camera->make_projection() * glm::mat4(player.camera->transform->make_world_to_local()));
@@ -1024,62 +1122,65 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
     //     }
     // }
 
-    {
-        // Draw a sign
+    frame_graph.add_pass("overlay", FrameGraph::Access().writes("backbuffer"), [&](){
+        {
+            // Draw a sign
 
-        // Currently it can not handle the situation when the sign is occluded by some other objects between it and the camera
-        if(animated == NO){
-            std::string name;
-            glm::vec3 pos;
-            std::tie(name,pos) = find_closest_sign();
+            // Currently it can not handle the situation when the sign is occluded by some other objects between it and the camera
+            if(animated == NO){
+                std::string name;
+                glm::vec3 pos;
+                std::tie(name,pos) = find_closest_sign();
 
-            glm::mat4 world_to_clip = player.camera->make_projection() * glm::mat4(player.camera->transform->make_world_to_local());
+                glm::mat4 world_to_clip = player.camera->make_projection() * glm::mat4(player.camera->transform->make_world_to_local());
 
-            if (!name.empty()){
+                if (!name.empty()){
                 
-                glm::vec4 clip_space = world_to_clip * glm::vec4{pos,1.0};
+                    glm::vec4 clip_space = world_to_clip * glm::vec4{pos,1.0};
                 
-                glm::vec3 clip_space_3d = glm::vec3{clip_space.x / clip_space.w,clip_space.y/clip_space.w,clip_space.z/clip_space.w};
+                    glm::vec3 clip_space_3d = glm::vec3{clip_space.x / clip_space.w,clip_space.y/clip_space.w,clip_space.z/clip_space.w};
 
-                draw_keyboard_sign(clip_space_3d);
+                    draw_keyboard_sign(clip_space_3d);
+                }
             }
-        }
 
-    }
+        }
 
     
 
-    if(animated == NO)
-    // Draw a crosshair at the center of the screen
-    {
-        glDisable(GL_DEPTH_TEST);
-//        glm::vec2 center{0.0f,0.0f};
-        float aspect = float(drawable_size.x) / float(drawable_size.y);
-        DrawLines lines(glm::mat4(
-                1.0f / aspect, 0.0f, 0.0f, 0.0f,
-                0.0f, 1.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 1.0f, 0.0f,
-                0.0f, 0.0f, 0.0f, 1.0f
-        ));
+        if(animated == NO)
+        // Draw a crosshair at the center of the screen
+        {
+            glDisable(GL_DEPTH_TEST);
+    //        glm::vec2 center{0.0f,0.0f};
+            float aspect = float(drawable_size.x) / float(drawable_size.y);
+            DrawLines lines(glm::mat4(
+                    1.0f / aspect, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f, 1.0f
+            ));
         
-        glm::vec2 offset(0.05f, 0.05f);
+            glm::vec2 offset(0.05f, 0.05f);
         
-        glm::vec3 pv_0 = {0.0f, 0.0f + offset[1], 0.0f};
-        glm::vec3 pv_1 = {0.0f, 0.0f - offset[1], 0.0f};
+            glm::vec3 pv_0 = {0.0f, 0.0f + offset[1], 0.0f};
+            glm::vec3 pv_1 = {0.0f, 0.0f - offset[1], 0.0f};
         
-        glm::vec3 ph_0 = {0.0f + offset[0], 0.0f, 0.0f};
-        glm::vec3 ph_1 = {0.0f - offset[1], 0.0f, 0.0f};
+            glm::vec3 ph_0 = {0.0f + offset[0], 0.0f, 0.0f};
+            glm::vec3 ph_1 = {0.0f - offset[1], 0.0f, 0.0f};
         
-        lines.draw(pv_0, pv_1);
-        lines.draw(ph_0, ph_1);
-        glEnable(GL_DEPTH_TEST);
-    }
+            lines.draw(pv_0, pv_1);
+            lines.draw(ph_0, ph_1);
+            glEnable(GL_DEPTH_TEST);
+        }
 
-    
-    
-    //draw_image(image_vao, shadow_depth_tex, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), 0.4f, 0.4f, 0.2f, 0.2f);
-    
-    Draw::handle_all();
+
+        //draw_image(image_vao, shadow_depth_tex, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), 0.4f, 0.4f, 0.2f, 0.2f);
+
+        Draw::handle_all();
+    });
+
+    frame_graph.run();
     GL_ERRORS();
 }
 
@@ -1094,7 +1195,8 @@ void PlayMode::update_wireframe(const std::shared_ptr<Scene::Collider> &c) {
     }
     
     
-    if (c->name.find("wire") == std::string::npos) {
+    static NameIndex::Tag const wire_tag = NameIndex::get().tag("wire");
+    if (!c->has_tag(wire_tag)) {
         return;
     }
     
@@ -1111,7 +1213,7 @@ void PlayMode::update_wireframe(const std::shared_ptr<Scene::Collider> &c) {
     
     
     if (!player.has_paint_ability) {
-        if (c->name.find("Paintbrush") == std::string::npos) {
+        if (!c->has_tag(paintbrush_tag())) {
             return;
         }
     }
@@ -1145,8 +1247,9 @@ void PlayMode::update_wireframe(const std::shared_ptr<Scene::Collider> &c) {
         if(c->name.find("frontroom")!=std::string::npos){
             is_changing_scene = true;
             start_timepoint = std::chrono::system_clock::now();
-            //change to foodworld?
-            scene = scene_map[FOODSCENE];
+            //change to foodworld (once it has streamed in; see update()):
+            next_scene = FOODSCENE;
+            levels.request(level_name(FOODSCENE));
             bgm->stop(1.0);
             text_display.remove_all_text();
  
@@ -1157,8 +1260,6 @@ void PlayMode::update_wireframe(const std::shared_ptr<Scene::Collider> &c) {
             text_display.add_text(tmpstr);
             if(!text_display.is_activated())
                 text_display.activate();
-            walkmesh = &foodworld_walkmeshes->lookup("WalkMesh");
-            initialize_player();
             bgm = Sound::loop(*fire_sample);
         }
 
@@ -1182,7 +1283,7 @@ void PlayMode::update_wireframe(const std::shared_ptr<Scene::Collider> &c) {
         d->wireframe_info.draw_frame = true;
     }
     
-    if (c->name.find("Paintbrush") != std::string::npos) {
+    if (c->has_tag(paintbrush_tag())) {
         player.has_paint_ability = true;
     }
 
@@ -1233,7 +1334,7 @@ void PlayMode::update_wireframe() {
         }
     } else { // Paintbrush case // This is ugly code but it works..
         for (const auto &collider: scene->wireframe_objects) {
-            if (collider->name == player.name || collider->name.find("Paintbrush") == std::string::npos) {
+            if (collider->name == player.name || !collider->has_tag(paintbrush_tag())) {
                 continue;
             }
             auto dist = c->min_distance(collider);
@@ -1253,7 +1354,7 @@ void PlayMode::update_wireframe() {
             // Add it back
             for (const auto &it: scene->current_wireframe_objects_map) {
                 const std::string &name = it.first;
-                if (name.find("Paintbrush") == std::string::npos) {
+                if (!it.second->has_tag(paintbrush_tag())) {
                     continue;
                 }
                 
@@ -1326,8 +1427,9 @@ void PlayMode::unlock(const std::string &prefix) {
     std::shared_ptr<Scene::Collider> collider_to_remove = nullptr;
     std::string name_to_remove;
     
+    NameIndex::Tag const prefix_tag = NameIndex::get().tag(prefix);
     for (const auto &collider: scene->colliders) {
-        if (collider->name.find(prefix) != std::string::npos) {
+        if (collider->has_tag(prefix_tag)) {
             auto dist = c->min_distance(collider);
             if (dist < 2.0) {
                 collider_to_remove = collider;
@@ -1389,9 +1491,10 @@ PlayMode::mouse_text_check(const std::string &prefix, bool use_crosshair) {
     
     std::shared_ptr<Scene::Collider> intersected_collider = nullptr;
     
+    NameIndex::Tag const prefix_tag = NameIndex::get().tag(prefix);
     for (const auto &it: scene->textcollider_name_map) {
         auto c = it.second;
-        if (c->name.find(prefix) != std::string::npos) {
+        if (c->has_tag(prefix_tag)) {
             bool intersected;
             float t;
             std::tie(intersected, t) = c->ray_intersect(dir);
@@ -1456,10 +1559,11 @@ PlayMode::mouse_collider_check(const std::string &prefix, bool use_crosshair) {
     std::shared_ptr<Scene::Collider> intersected_collider = nullptr;
     
 
+    NameIndex::Tag const prefix_tag = NameIndex::get().tag(prefix);
     if(prefix.find("terminal")!=std::string::npos){
         for (const auto &it: scene->terminal_name_map) {
             auto c = it.second;
-            if (c->name.find(prefix) != std::string::npos || c->name.find("Paintbrush") != std::string::npos) {
+            if (c->has_tag(prefix_tag) || c->has_tag(paintbrush_tag())) {
                 bool intersected;
                 float t;
                 std::tie(intersected, t) = c->ray_intersect(dir);
@@ -1476,7 +1580,7 @@ PlayMode::mouse_collider_check(const std::string &prefix, bool use_crosshair) {
     }else{
         for (const auto &it: scene->collider_name_map) {
             auto c = it.second;
-            if (c->name.find(prefix) != std::string::npos || c->name.find("Paintbrush") != std::string::npos) {
+            if (c->has_tag(prefix_tag) || c->has_tag(paintbrush_tag())) {
                 bool intersected;
                 float t;
                 std::tie(intersected, t) = c->ray_intersect(dir);
@@ -1545,9 +1649,10 @@ PlayMode::mouse_bread_check(const std::string &prefix, bool use_crosshair) {
     
     std::shared_ptr<Scene::Collider> intersected_collider = nullptr;
     
+    NameIndex::Tag const prefix_tag = NameIndex::get().tag(prefix);
     for (const auto &it: scene->breadcollider_name_map) {
         auto c = it.second;
-        if (c->name.find(prefix) != std::string::npos || c->name.find("Paintbrush") != std::string::npos) {
+        if (c->has_tag(prefix_tag) || c->has_tag(paintbrush_tag())) {
             bool intersected;
             float t;
             std::tie(intersected, t) = c->ray_intersect(dir);
@@ -1572,13 +1677,15 @@ ColliderType PlayMode::check_collider_type(std::shared_ptr<Scene::Collider> c) {
         std::runtime_error("NULL pointer");
         return UNKNOWN;
     } else {
-        const std::string &name = c->name;
+        static NameIndex::Tag const wire_tag = NameIndex::get().tag("col_wire");
+        static NameIndex::Tag const unlock_tag = NameIndex::get().tag("col_unlock");
+        static NameIndex::Tag const food_tag = NameIndex::get().tag("col_food");
         
-        if (name.find("col_wire") != std::string::npos) {
+        if (c->has_tag(wire_tag)) {
             return WIREFRAME;
-        } else if (name.find("col_unlock") != std::string::npos) {
+        } else if (c->has_tag(unlock_tag)) {
             return DOOR;
-        } else if (name.find("col_food") != std::string::npos) {
+        } else if (c->has_tag(food_tag)) {
             return FOOD;
         } else {
             std::runtime_error("Unkonwn collider type");
@@ -1592,9 +1699,10 @@ ColliderType PlayMode::check_collider_type(std::shared_ptr<Scene::Collider> c) {
 
 
 
-void PlayMode::initialize_scene(Load<Scene> scene_to_copy, Load<MeshBuffer> meshbuffer_param, scene_type scene_param_type){
+void PlayMode::initialize_scene(LevelStreamer::Level const &level, scene_type scene_param_type){
     
-    std::shared_ptr<Scene> new_scene = std::make_shared<Scene>(*scene_to_copy);
+    std::shared_ptr<Scene> new_scene = std::make_shared<Scene>(*level.scene);
+    MeshBuffer const &meshbuffer_param = *level.meshes;
 
 
     //create a player transform:
@@ -1619,23 +1727,48 @@ void PlayMode::initialize_scene(Load<Scene> scene_to_copy, Load<MeshBuffer> mesh
     
     wizard_drawable->pipeline = rocket_color_texture_program_pipeline;
     
-    wizard_drawable->pipeline.vao = wizard_meshes_for_lit_color_texture_program;
-    wizard_drawable->pipeline.type = mesh.type;
-    wizard_drawable->pipeline.start = mesh.start;
-    wizard_drawable->pipeline.count = mesh.count;
+    wizard_drawable->pipeline.write().vao = wizard_meshes_for_lit_color_texture_program;
+    wizard_drawable->pipeline.write().type = mesh.type;
+    wizard_drawable->pipeline.write().start = mesh.start;
+    wizard_drawable->pipeline.write().count = mesh.count;
+    wizard_drawable->bounds_min = mesh.min;
+    wizard_drawable->bounds_max = mesh.max;
     wizard_drawable->specular_info.shininess = 10.0f;
     wizard_drawable->specular_info.specular_brightness = glm::vec3(1.0f, 0.9f, 0.7f);
     wizard_drawable->scene_info.type = scene_param_type;
+    wizard_drawable->dynamic = true;
     
     new_scene->initialize_scene_metadata();
-    new_scene->initialize_collider("col_", meshbuffer_param);
-    new_scene->initialize_wireframe_objects("col_wire");
-    new_scene->initialize_text_collider("text_", meshbuffer_param);
-    new_scene->initialize_bread("bread_",meshbuffer_param);
+    if (level.baked) {
+        //colliders were computed by bake-scene:
+        new_scene->initialize_baked(*level.baked);
+        new_scene->initialize_wireframe_objects("col_wire");
+    } else {
+        new_scene->initialize_collider("col_", meshbuffer_param);
+        new_scene->initialize_wireframe_objects("col_wire");
+        new_scene->initialize_text_collider("text_", meshbuffer_param);
+        new_scene->initialize_bread("bread_",meshbuffer_param);
+    }
 
     scene_map[scene_param_type] = new_scene;
 }
 
+void PlayMode::change_scene(scene_type to) {
+    LevelStreamer::Level *level = levels.get(level_name(to));
+    assert(level && scene_map.count(to));
+    
+    scene_type from = current_scene;
+    scene = scene_map[to];
+    current_scene = to;
+    walkmesh = &level->walkmeshes->lookup("WalkMesh");
+    register_text_bearers(*level);
+    initialize_player();
+    
+    //the level we left isn't needed anymore:
+    scene_map.erase(from);
+    levels.evict(level_name(from));
+}
+
 
 void PlayMode::initialize_player(){
 
@@ -6,6 +6,9 @@
 #include "Load.hpp"
 #include "Mesh.hpp"
 #include "Terminal.hpp"
+#include "ECS/Scheduler.hpp"
+#include "FrameGraph.hpp"
+#include "LevelStreamer.hpp"
 #include "spline.h"
 #include "load_save_png.hpp"
 
@@ -52,7 +55,10 @@ struct PlayMode : Mode {
         uint8_t downs = 0;
         uint8_t pressed = 0;
     } left, right, down, up, esc, read, lrun, rrun;
-    // camera animation
+    //update_scheduler names Button::downs separately (only events and reset_button_downs touch the counters):
+    struct ButtonDowns;
+    // camera animation (animated, animationTime and the splines are CameraAnimation to update_scheduler)
+    struct CameraAnimation;
     animation_t animated = NO;
     float animationTime = 0.0f;
     Spline<glm::vec3> splineposition;
@@ -60,16 +66,34 @@ struct PlayMode : Mode {
 
     GLuint depth_fb;
     GLuint depth_tex;
+    //ComicBookProgram's outline mask, made from depth_tex by EdgeDetectProgram (edge_tmp_* holds the first of its two passes):
+    GLuint edge_tmp_fb;
+    GLuint edge_tmp_tex;
+    GLuint edge_fb;
+    GLuint edge_tex;
     GLuint dot_tex;
     GLuint R_tex;
 
+    //the shadow map the scene programs sample (static shadows + this frame's dynamic casters):
     GLuint shadow_depth_fb;
     GLuint shadow_depth_tex;
+    //..and the static casters' part of it, re-drawn only when Scene::static_shadow_signature() changes:
+    GLuint static_shadow_fb;
+    GLuint static_shadow_tex;
+    bool static_shadow_valid = false;
+    uint64_t static_shadow_signature = 0;
+    //both are shadow_map_size x shadow_map_size, whatever the window size (MAGITECH_SHADOW_MAP_SIZE overrides):
+    GLsizei shadow_map_size = 4096;
 
     SDL_Window* window;
     //local copy of the game scene (so code can change it during gameplay):
     std::shared_ptr<Scene> scene;
     std::map<scene_type,std::shared_ptr<Scene>> scene_map;
+    //what the camera / the shadow light can see this frame (culled once in draw(), used by every pass):
+    // (light_visible holds just the dynamic casters; static_light_visible is culled when the static shadows are re-drawn)
+    Scene::Visible camera_visible, light_visible, static_light_visible;
+    //draw() declares its passes (culls, depth, edges, static / dynamic shadow, color, overlay) to this each frame:
+    FrameGraph frame_graph;
     std::shared_ptr<Sound::PlayingSample> bgm;
     std::shared_ptr<Sound::PlayingSample> walk, walk_15x;
     
@@ -109,7 +133,21 @@ struct PlayMode : Mode {
 
     } player;
 
-    void initialize_scene(Load<Scene>, Load<MeshBuffer>, scene_type);
+    //update() runs these systems through update_scheduler (set up in the constructor):
+    Scheduler update_scheduler;
+    void update_sign_reading();
+    void update_camera_animation(float elapsed);
+    void update_player_movement(float elapsed);
+    void update_footsteps();
+    void update_player_collider();
+    void reset_button_downs();
+
+    //levels are streamed in the background; scene_map holds this PlayMode's copy of each loaded one:
+    LevelStreamer levels;
+    scene_type current_scene = ARTSCENE;
+    scene_type next_scene = ARTSCENE; //update() switches to it once it has streamed in
+    void initialize_scene(LevelStreamer::Level const &, scene_type);
+    void change_scene(scene_type to);
     // Should be called after this->scene is not null
     void initialize_player();
 
@@ -0,0 +1,126 @@
+#include "RenderQueue.hpp"
+
+#include <cassert>
+#include <cstring>
+
+void RenderQueue::clear() {
+	items.clear();
+	programs.clear();
+	vaos.clear();
+	texture_sets.clear();
+	meshes.clear();
+}
+
+uint32_t RenderQueue::Ranks::operator()(uint64_t value) {
+	return ranks.emplace(value, uint32_t(ranks.size())).first->second;
+}
+
+uint64_t RenderQueue::make_key(uint32_t pass, uint32_t program_rank, uint32_t vao_rank, uint32_t texture_rank, uint32_t mesh_rank, float depth) {
+	//(ranks past a field's width just share its top value, which only costs some sorting)
+	auto field = [](uint32_t value, uint32_t bits) -> uint64_t {
+		return value < (1u << bits) ? value : (1u << bits) - 1;
+	};
+
+	//the bits of a non-negative float sort like the float, so the top 20 (after the sign) make a
+	// coarse, monotonic depth:
+	uint32_t depth_bits = 0;
+	if (depth > 0.0f) {
+		std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+		depth_bits >>= 11;
+	}
+
+	return (field(pass, 4) << 60)
+	     | (field(program_rank, 8) << 52)
+	     | (field(vao_rank, 10) << 42)
+	     | (field(texture_rank, 10) << 32)
+	     | (field(mesh_rank, 12) << 20)
+	     | field(depth_bits, 20);
+}
+
+void RenderQueue::sort() {
+	if (items.size() < 2) return;
+
+	//bytes where keys differ at all (the rest are skipped):
+	uint64_t all_and = ~uint64_t(0), all_or = 0;
+	for (Item const &item : items) {
+		all_and &= item.key;
+		all_or |= item.key;
+	}
+	uint64_t varying = all_and ^ all_or;
+
+	scratch.resize(items.size());
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		if (((varying >> shift) & 0xff) == 0) continue;
+
+		//counting sort by this byte (stable, so earlier bytes' order is kept):
+		uint32_t offsets[256] = {0};
+		for (Item const &item : items) {
+			offsets[(item.key >> shift) & 0xff] += 1;
+		}
+		uint32_t total = 0;
+		for (uint32_t &o : offsets) {
+			uint32_t count = o;
+			o = total;
+			total += count;
+		}
+		for (Item const &item : items) {
+			scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+		}
+		items.swap(scratch);
+	}
+}
+
+//--------------------------------------------------------------
+
+bool RenderQueue::State::use_program(GLuint program_) {
+	if (program_ == program) return false;
+	glUseProgram(program_);
+	program = program_;
+	changes.programs += 1;
+	return true;
+}
+
+bool RenderQueue::State::bind_vertex_array(GLuint vao_) {
+	if (vao_ == vao) return false;
+	glBindVertexArray(vao_);
+	vao = vao_;
+	changes.vaos += 1;
+	return true;
+}
+
+bool RenderQueue::State::bind_texture(uint32_t unit, GLenum target, GLuint texture) {
+	assert(unit < TextureUnits);
+	if (textures[unit] == texture && texture_targets[unit] == target) return false;
+	if (active_unit != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		active_unit = unit;
+	}
+	if (texture_targets[unit] != target && textures[unit] != 0) {
+		//(unbind the old target so it doesn't linger on this unit)
+		glBindTexture(texture_targets[unit], 0);
+	}
+	glBindTexture(target, texture);
+	texture_targets[unit] = target;
+	textures[unit] = texture;
+	changes.textures += 1;
+	return true;
+}
+
+void RenderQueue::State::reset() {
+	for (uint32_t unit = 0; unit < TextureUnits; ++unit) {
+		if (textures[unit] != 0) {
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(texture_targets[unit], 0);
+			textures[unit] = 0;
+		}
+	}
+	glActiveTexture(GL_TEXTURE0);
+	active_unit = 0;
+
+	glUseProgram(0);
+	program = 0;
+	glBindVertexArray(0);
+	vao = 0;
+
+	changes.programs = changes.vaos = changes.textures = 0;
+}
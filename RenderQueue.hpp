@@ -0,0 +1,80 @@
+#pragma once
+
+/*
+ * Draw-call ordering and redundant-state filtering for Scene::draw / draw_shadow:
+ *  - each frame, every visible drawable is added with a 64-bit sort key:
+ *      | pass (4) | program (8) | vertex array (10) | texture set (10) | mesh (12) | depth (20) |
+ *    where program / vertex array / texture set / mesh (vertex range) are small per-frame ranks
+ *    (first come, first ranked), and depth is front-to-back; keeping draws of one mesh adjacent
+ *    lets Scene::draw turn them into a single instanced draw
+ *  - sort() orders the keys with an LSD radix sort (skipping bytes every key shares)
+ *  - RenderQueue::State remembers the bound program / vertex array / textures, so walking the
+ *    sorted queue only issues the GL calls whose state actually changes
+ */
+
+#include "GL.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct RenderQueue {
+	struct Item {
+		uint64_t key;
+		uint32_t index; //caller's index of what to draw
+	};
+	std::vector< Item > items;
+
+	//start a new frame:
+	void clear();
+
+	void add(uint64_t key, uint32_t index) { items.emplace_back(Item{key, index}); }
+
+	//sort 'items' by key (stable):
+	void sort();
+
+	//--- keys ---
+
+	//dense, per-frame rank of a piece of state (first value seen gets 0, and so on):
+	struct Ranks {
+		uint32_t operator()(uint64_t value);
+		void clear() { ranks.clear(); }
+		std::unordered_map< uint64_t, uint32_t > ranks;
+	};
+	Ranks programs, vaos, texture_sets, meshes;
+
+	//pack a key; 'depth' is distance along the view direction (smaller draws first):
+	static uint64_t make_key(uint32_t pass, uint32_t program_rank, uint32_t vao_rank, uint32_t texture_rank, uint32_t mesh_rank, float depth);
+
+	//--- state filtering ---
+
+	static constexpr uint32_t TextureUnits = 4;
+
+	struct State {
+		//bind only if different from what is bound:
+		// (each returns true if it changed anything)
+		bool use_program(GLuint program);
+		bool bind_vertex_array(GLuint vao);
+		bool bind_texture(uint32_t unit, GLenum target, GLuint texture);
+
+		//unbind everything bound through this State (and reset it):
+		void reset();
+
+		GLuint program = 0;
+		GLuint vao = 0;
+		GLenum texture_targets[TextureUnits] = {GL_TEXTURE_2D, GL_TEXTURE_2D, GL_TEXTURE_2D, GL_TEXTURE_2D};
+		GLuint textures[TextureUnits] = {0, 0, 0, 0};
+		uint32_t active_unit = 0;
+
+		//state changes actually issued since the last reset():
+		struct {
+			uint32_t programs = 0;
+			uint32_t vaos = 0;
+			uint32_t textures = 0;
+		} changes;
+	};
+	State state;
+
+private:
+	std::vector< Item > scratch;
+};
@@ -4,6 +4,8 @@
 
 #include "RocketColorTextureProgram.hpp"
 
+#include "Mesh.hpp"
+#include "UniformBlocks.hpp"
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
 #include "glm/ext.hpp"
@@ -22,22 +24,15 @@ Load<RocketColorTextureProgram> rocket_color_texture_program(LoadTagEarly, []()
     rocket_color_texture_program_pipeline.SPECULAR_BRIGHTNESS_vec3 = ret->SPECULAR_BRIGHTNESS_vec3;
     rocket_color_texture_program_pipeline.SPECULAR_SHININESS_float = ret->SPECULAR_SHININESS_float;
     rocket_color_texture_program_pipeline.draw_frame = ret->draw_frame;
-    rocket_color_texture_program_pipeline.set_uniforms = [ret]() {
-        glUniform1i(ret->LIGHT_TYPE_int, 1);
-        glUniform3fv(ret->LIGHT_DIRECTION_vec3, 1,
-                     glm::value_ptr(glm::normalize(glm::vec3(-0.5f, -1.0f, 1.0f))));
-        glUniform3fv(ret->LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(0.85f, 0.85f, 0.85f)));
-        glUniform3fv(ret->AMBIENT_LIGHT_ENERGY_vec3, 1,
-                     glm::value_ptr(glm::vec3(0.25f, 0.25f, 0.25f)));
-    };
-    
-    /* This will be used later if/when we build a light loop into the Scene:
-    rocket_color_texture_program_pipeline.LIGHT_TYPE_int = ret->LIGHT_TYPE_int;
-    rocket_color_texture_program_pipeline.LIGHT_LOCATION_vec3 = ret->LIGHT_LOCATION_vec3;
-    rocket_color_texture_program_pipeline.LIGHT_DIRECTION_vec3 = ret->LIGHT_DIRECTION_vec3;
-    rocket_color_texture_program_pipeline.LIGHT_ENERGY_vec3 = ret->LIGHT_ENERGY_vec3;
-    rocket_color_texture_program_pipeline.LIGHT_CUTOFF_float = ret->LIGHT_CUTOFF_float;
-    */
+
+    //this program's light rig (both variants read it through their "Light" block); set once here,
+    // since nothing changes it afterwards:
+    UniformBlocks::Light light;
+    light.LIGHT_TYPE = 1;
+    light.LIGHT_DIRECTION = glm::normalize(glm::vec3(-0.5f, -1.0f, 1.0f));
+    light.LIGHT_ENERGY = glm::vec3(0.85f, 0.85f, 0.85f);
+    light.AMBIENT_LIGHT_ENERGY = glm::vec3(0.25f, 0.25f, 0.25f);
+    UniformBlocks::set_light(UniformBlocks::RocketLightBinding, light);
     
     //make a 1-pixel white texture to bind by default:
     GLuint tex;
@@ -59,14 +54,34 @@ Load<RocketColorTextureProgram> rocket_color_texture_program(LoadTagEarly, []()
     return ret;
 });
 
-RocketColorTextureProgram::RocketColorTextureProgram() {
+Load<RocketColorTextureProgram> rocket_color_texture_program_instanced(LoadTagEarly, []() -> RocketColorTextureProgram const * {
+    RocketColorTextureProgram *ret = new RocketColorTextureProgram(true);
+
+    //----- fill in the pipeline template's instanced variant -----
+    rocket_color_texture_program_pipeline.instanced.program = ret->program;
+    rocket_color_texture_program_pipeline.instanced.draw_frame = ret->draw_frame;
+
+    return ret;
+});
+
+RocketColorTextureProgram::RocketColorTextureProgram(bool instanced) {
+    //the instanced variant takes per-instance transforms / specular info as attributes (see MeshBuffer::Instance);
+    //camera, frame and light values come from the shared uniform blocks (see UniformBlocks.hpp):
+    std::string header = std::string(instanced ? "#version 330\n#define INSTANCED\n" : "#version 330\n") + UniformBlocks::GLSL;
+
     //Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
     program = gl_compile_program(
             //vertex shader:
-            "#version 330\n"
+            header + MeshBuffer::BarycentricVertexGLSL +
+            "#ifdef INSTANCED\n"
+            "in mat4x3 INSTANCE_TO_WORLD;\n"
+            "in vec4 INSTANCE_SPECULAR;\n"
+            "flat out vec4 instanceSpecular;\n"
+            "#else\n"
             "uniform mat4 OBJECT_TO_CLIP;\n"
             "uniform mat4x3 OBJECT_TO_LIGHT;\n"
             "uniform mat3 NORMAL_TO_LIGHT;\n"
+            "#endif\n"
             "in vec4 Position;\n"
             "in vec3 Normal;\n"
             "in vec4 Color;\n"
@@ -76,24 +91,30 @@ RocketColorTextureProgram::RocketColorTextureProgram() {
             "out vec4 color;\n"
             "out vec2 texCoord;\n"
             "void main() {\n"
+            "#ifdef INSTANCED\n"
+            "	mat4 OBJECT_TO_CLIP = WORLD_TO_CLIP * mat4(INSTANCE_TO_WORLD);\n"
+            "	mat4x3 OBJECT_TO_LIGHT = WORLD_TO_LIGHT * mat4(INSTANCE_TO_WORLD);\n"
+            "	mat3 NORMAL_TO_LIGHT = inverse(transpose(mat3(OBJECT_TO_LIGHT)));\n"
+            "	instanceSpecular = INSTANCE_SPECULAR;\n"
+            "#endif\n"
             "	gl_Position = OBJECT_TO_CLIP * Position;\n"
             "	position = OBJECT_TO_LIGHT * Position;\n"
             "	normal = NORMAL_TO_LIGHT * Normal;\n"
             "	color = Color;\n"
             "	texCoord = TexCoord;\n"
+            "	barycentric = Barycentric;\n"
             "}\n",
             //fragment shader:
-            "#version 330\n"
-            "uniform mat4 OBJECT_TO_CLIP;\n"
+            header + MeshBuffer::BarycentricFragmentGLSL +
             "uniform sampler2D TEX;\n"
-            "uniform int LIGHT_TYPE;\n"
-            "uniform vec3 LIGHT_LOCATION;\n"
-            "uniform vec3 LIGHT_DIRECTION;\n"
-            "uniform vec3 LIGHT_ENERGY;\n"
-            "uniform vec3 AMBIENT_LIGHT_ENERGY;\n"
+            "#ifdef INSTANCED\n"
+            "flat in vec4 instanceSpecular;\n"
+            "#define SPECULAR_SHININESS instanceSpecular.a\n"
+            "#define SPECULAR_BRIGHTNESS instanceSpecular.rgb\n"
+            "#else\n"
             "uniform float SPECULAR_SHININESS;\n"
             "uniform vec3 SPECULAR_BRIGHTNESS;\n"
-            "uniform float LIGHT_CUTOFF;\n"
+            "#endif\n"
             "in vec3 position;\n"
             "in vec3 normal;\n"
             "in vec4 color;\n"
@@ -101,13 +122,11 @@ RocketColorTextureProgram::RocketColorTextureProgram() {
             "out vec4 fragColor;\n"
             "uniform bool wireframe;\n"
             "// Code adapted from https://github.com/aehmttw/Machimania/blob/master/resources/shaders/main.frag\n"
-            "mat3 toMat3(mat4 matrix) {\n"
-            "    return mat3(matrix[0].xyz, matrix[1].xyz, matrix[2].xyz);\n"
-            "}\n"
             "float det(mat2 matrix) {\n"
             "    return matrix[0].x * matrix[1].y - matrix[0].y * matrix[1].x;\n"
             "}"
             "void main() {\n"
+            "	if (wireframe && offWireframe()) discard; //(wireframe drawables keep just their triangles' edges)\n"
             "	vec3 n = normalize(normal);\n"
             "	vec3 e;\n"
             "	if (LIGHT_TYPE == 0) { //point light \n"
@@ -129,7 +148,7 @@ RocketColorTextureProgram::RocketColorTextureProgram() {
             "	} else { //(LIGHT_TYPE == 3) //directional light \n"
             "		e = max(0.0, dot(n,-LIGHT_DIRECTION)) * LIGHT_ENERGY;\n"
             "	}\n"
-            "   vec3 cam = normalize((inverse(toMat3(OBJECT_TO_CLIP)) * vec3(0, 0, 1)).xyz);\n"
+            "   vec3 cam = VIEW_DIRECTION; //(the same for every object, however it is drawn)\n"
             "   vec3 h = normalize(cam + normalize(-LIGHT_DIRECTION));\n"
             "   float specular = pow(max(dot(n, h), 0), SPECULAR_SHININESS);\n" // changes made here
             "   e += specular * SPECULAR_BRIGHTNESS;\n"
@@ -156,16 +175,13 @@ RocketColorTextureProgram::RocketColorTextureProgram() {
     OBJECT_TO_LIGHT_mat4x3 = glGetUniformLocation(program, "OBJECT_TO_LIGHT");
     NORMAL_TO_LIGHT_mat3 = glGetUniformLocation(program, "NORMAL_TO_LIGHT");
 
-    LIGHT_TYPE_int = glGetUniformLocation(program, "LIGHT_TYPE");
-    LIGHT_LOCATION_vec3 = glGetUniformLocation(program, "LIGHT_LOCATION");
-    LIGHT_DIRECTION_vec3 = glGetUniformLocation(program, "LIGHT_DIRECTION");
-    LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "LIGHT_ENERGY");
-    AMBIENT_LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "AMBIENT_LIGHT_ENERGY");
-    LIGHT_CUTOFF_float = glGetUniformLocation(program, "LIGHT_CUTOFF");
     SPECULAR_BRIGHTNESS_vec3 = glGetUniformLocation(program, "SPECULAR_BRIGHTNESS");
     SPECULAR_SHININESS_float = glGetUniformLocation(program, "SPECULAR_SHININESS");
     
     draw_frame = glGetUniformLocation(program, "wireframe");
+
+    //point the uniform blocks at the shared buffers:
+    UniformBlocks::bind(program, UniformBlocks::RocketLightBinding);
     
     
     GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
@@ -6,7 +6,7 @@
 
 //Shader program that draws transformed, lit, textured vertices tinted with vertex colors:
 struct RocketColorTextureProgram {
-    RocketColorTextureProgram();
+    RocketColorTextureProgram(bool instanced = false);
     ~RocketColorTextureProgram();
     
     GLuint program = 0;
@@ -21,14 +21,7 @@ struct RocketColorTextureProgram {
     GLuint OBJECT_TO_CLIP_mat4 = -1U;
     GLuint OBJECT_TO_LIGHT_mat4x3 = -1U;
     GLuint NORMAL_TO_LIGHT_mat3 = -1U;
-    
-    //lighting:
-    GLuint LIGHT_TYPE_int = -1U;
-    GLuint LIGHT_LOCATION_vec3 = -1U;
-    GLuint LIGHT_DIRECTION_vec3 = -1U;
-    GLuint LIGHT_ENERGY_vec3 = -1U;
-    GLuint AMBIENT_LIGHT_ENERGY_vec3 = -1U;
-    GLuint LIGHT_CUTOFF_float = -1U;
+    //(camera, window and lighting values are in the shared uniform blocks; see UniformBlocks.hpp)
     
     // How bright specular reflections (mirror effect of light) should be
     GLuint SPECULAR_BRIGHTNESS_vec3 = -1U;
@@ -45,6 +38,8 @@ struct RocketColorTextureProgram {
 };
 
 extern Load< RocketColorTextureProgram > rocket_color_texture_program;
+//(same program compiled with INSTANCED; fills in rocket_color_texture_program_pipeline.instanced)
+extern Load< RocketColorTextureProgram > rocket_color_texture_program_instanced;
 
 //For convenient scene-graph setup, copy this object:
 // NOTE: by default, has texture bound to 1-pixel white texture -- so it's okay to use with vertex-color-only meshes.
@@ -1,13 +1,15 @@
 #include "Scene.hpp"
 
 #include "gl_errors.hpp"
-#include "read_write_chunk.hpp"
 #include "ShadowMapProgram.hpp"
+#include "UniformBlocks.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
 
 //-------------------------
 
@@ -58,18 +60,130 @@ glm::mat4x3 Scene::Transform::make_parent_to_local() const {
 	);
 }
 
+//versions are unique across all transforms, so a child also notices its parent being replaced:
+// (atomic, since transforms are refreshed on ThreadPool workers too)
+static std::atomic< uint64_t > next_transform_version(1);
+
 glm::mat4x3 Scene::Transform::make_local_to_world() const {
-	if (!parent) {
-		return make_local_to_parent();
-	} else {
-		return parent->make_local_to_world() * glm::mat4(make_local_to_parent()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
-	}
+	refresh();
+	return cache.local_to_world;
 }
 glm::mat4x3 Scene::Transform::make_world_to_local() const {
+	refresh();
+	return cache.world_to_local;
+}
+
+void Scene::Transform::refresh() const {
+	uint64_t parent_version = 0;
+	if (parent) {
+		parent->refresh();
+		parent_version = parent->cache.version;
+	}
+
+	if (cache.version != 0
+		&& cache.parent == parent && cache.parent_version == parent_version
+		&& cache.position == position && cache.rotation == rotation && cache.scale == scale) {
+		return;
+	}
+
 	if (!parent) {
-		return make_parent_to_local();
+		cache.local_to_world = make_local_to_parent();
+		cache.world_to_local = make_parent_to_local();
 	} else {
-		return make_parent_to_local() * glm::mat4(parent->make_world_to_local()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		cache.local_to_world = parent->cache.local_to_world * glm::mat4(make_local_to_parent()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		cache.world_to_local = make_parent_to_local() * glm::mat4(parent->cache.world_to_local);
+	}
+	cache.position = position;
+	cache.rotation = rotation;
+	cache.scale = scale;
+	cache.parent = parent;
+	cache.parent_version = parent_version;
+
+	cache.version = next_transform_version.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Scene::update_transforms() {
+	//the flattened order is only rebuilt when transforms are added or reparented:
+	bool valid = (hierarchy_nodes.size() == transforms.size());
+	for (size_t i = 0; valid && i < hierarchy_nodes.size(); ++i) {
+		valid = (hierarchy_nodes[i]->parent == hierarchy_parents[i]);
+	}
+	if (!valid) rebuild_hierarchy();
+
+	//find the transforms that changed since their cache was built -- their own members, or their parents
+	// (rebuilt earlier in this sweep, or by refresh() since the last one); the rest keep cache and version:
+	hierarchy_dirty.assign(hierarchy_nodes.size(), 0);
+	bool any_dirty = false;
+	for (size_t i = 0; i < hierarchy_nodes.size(); ++i) {
+		Transform const &t = *hierarchy_nodes[i];
+		uint32_t parent = hierarchy.parent[i];
+		hierarchy_dirty[i] = (t.cache.version == 0
+			|| t.cache.parent != t.parent
+			|| t.cache.parent_version != (t.parent ? t.parent->cache.version : 0)
+			|| (parent != TransformHierarchy::NoParent && hierarchy_dirty[parent])
+			|| t.cache.position != t.position || t.cache.rotation != t.rotation || t.cache.scale != t.scale);
+		any_dirty = any_dirty || hierarchy_dirty[i];
+	}
+
+	if (any_dirty) {
+		for (size_t i = 0; i < hierarchy_nodes.size(); ++i) {
+			Transform const &t = *hierarchy_nodes[i];
+			hierarchy.set(i, t.position, t.rotation, t.scale, hierarchy.parent[i]);
+		}
+		hierarchy.compute();
+	}
+
+	//store the results as the changed transforms' caches (parents first, so their new versions are known):
+	for (size_t i = 0; i < hierarchy_nodes.size(); ++i) {
+		Transform &t = *hierarchy_nodes[i];
+		if (!hierarchy_dirty[i]) continue;
+		t.cache.local_to_world = hierarchy.get_local_to_world(i);
+		t.cache.world_to_local = hierarchy.get_world_to_local(i);
+		t.cache.position = t.position;
+		t.cache.rotation = t.rotation;
+		t.cache.scale = t.scale;
+		t.cache.parent = t.parent;
+		t.cache.parent_version = (t.parent ? t.parent->cache.version : 0);
+		t.cache.version = next_transform_version.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void Scene::rebuild_hierarchy() {
+	hierarchy_nodes.clear();
+	for (auto &t : transforms) {
+		hierarchy_nodes.emplace_back(&t);
+	}
+
+	//sort by depth, so every parent comes before its children:
+	std::unordered_map< Transform const *, uint32_t > depth;
+	for (Transform *t : hierarchy_nodes) {
+		uint32_t d = 0;
+		for (Transform const *p = t->parent; p; p = p->parent) ++d;
+		depth[t] = d;
+	}
+	std::stable_sort(hierarchy_nodes.begin(), hierarchy_nodes.end(), [&](Transform const *a, Transform const *b) {
+		return depth.at(a) < depth.at(b);
+	});
+
+	std::unordered_map< Transform const *, uint32_t > index;
+	for (uint32_t i = 0; i < hierarchy_nodes.size(); ++i) {
+		index[hierarchy_nodes[i]] = i;
+	}
+
+	hierarchy.resize(hierarchy_nodes.size());
+	hierarchy_parents.resize(hierarchy_nodes.size());
+	for (size_t i = 0; i < hierarchy_nodes.size(); ++i) {
+		Transform const *parent = hierarchy_nodes[i]->parent;
+		hierarchy_parents[i] = parent;
+		if (!parent) {
+			hierarchy.parent[i] = TransformHierarchy::NoParent;
+		} else {
+			auto f = index.find(parent);
+			if (f == index.end()) {
+				throw std::runtime_error("Transform '" + hierarchy_nodes[i]->name + "' has a parent that is not in its scene.");
+			}
+			hierarchy.parent[i] = f->second;
+		}
 	}
 }
 
@@ -79,73 +193,327 @@ glm::mat4 Scene::Camera::make_projection() const {
 	return glm::infinitePerspective( fovy, aspect, near );
 }
 
+glm::mat4 Scene::Camera::make_world_to_clip() const {
+	assert(transform);
+	return make_projection() * glm::mat4(transform->make_world_to_local());
+}
+
 //-------------------------
 
 
-void Scene::draw(Camera const &camera, bool draw_frame ) const {
-	assert(camera.transform);
-	glm::mat4 world_to_clip = camera.make_projection() * glm::mat4(camera.transform->make_world_to_local());
+glm::mat4x3 Scene::default_world_to_light() {
     glm::mat4 rot = glm::toMat4(glm::angleAxis(glm::radians(-45.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(glm::radians(-22.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-    glm::mat4x3 world_to_light = (0.25f * glm::mat4x3(0.03f, 0.0f, 0.0f,  0.0f, 0.03f, 0.0f,  0.0f, 0.0f, -0.03f,  0.0f, 0.0f, 0.0f)) * rot;
-	draw(world_to_clip, world_to_light, draw_frame);
+    return (0.25f * glm::mat4x3(0.03f, 0.0f, 0.0f,  0.0f, 0.03f, 0.0f,  0.0f, 0.0f, -0.03f,  0.0f, 0.0f, 0.0f)) * rot;
 }
 
-void Scene::draw_shadow(Camera const &camera, bool draw_frame ) const {
-    assert(camera.transform);
-    glm::mat4 world_to_clip = camera.make_projection() * glm::mat4(camera.transform->make_world_to_local());
-    glm::mat4 rot = glm::toMat4(glm::angleAxis(glm::radians(-45.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(glm::radians(-22.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-    glm::mat4x3 world_to_light = (0.25f * glm::mat4x3(0.03f, 0.0f, 0.0f,  0.0f, 0.03f, 0.0f,  0.0f, 0.0f, -0.03f,  0.0f, 0.0f, 0.0f)) * rot;
-    draw_shadow(world_to_clip, world_to_light, draw_frame);
+void Scene::draw(Camera const &camera, Visible const *visible) const {
+	draw(camera.make_world_to_clip(), default_world_to_light(), visible);
 }
 
-void Scene::draw_shadow(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, bool draw_frame) const
+void Scene::draw_shadow(Camera const &camera, Visible const *visible) const {
+    draw_shadow(camera.make_world_to_clip(), default_world_to_light(), visible);
+}
+
+void Scene::cull(glm::mat4 const &world_to_clip, Visible &visible, CullFilter filter) const {
+	visible.drawables.clear();
+
+	//gather world-space boxes (re-computed only for drawables whose transform changed):
+	cull_boxes.clear();
+	cull_candidates.clear();
+	for (auto const &drawable : drawables) {
+		if (filter != AllDrawables && drawable->dynamic != (filter == DynamicDrawables)) continue;
+		if (!drawable->has_bounds()) {
+			visible.drawables.emplace_back(drawable.get()); //(nothing to cull by)
+			continue;
+		}
+		assert(drawable->transform); //drawables *must* have a transform
+		glm::mat4x3 const &object_to_world = drawable->transform->make_local_to_world();
+		auto &bounds = drawable->world_bounds;
+		if (bounds.transform_version != drawable->transform->cache.version) {
+			//the box's center moves with the transform; its extent is the object extent through |rotation*scale|:
+			glm::vec3 center = 0.5f * (drawable->bounds_min + drawable->bounds_max);
+			glm::vec3 extent = 0.5f * (drawable->bounds_max - drawable->bounds_min);
+			bounds.center = object_to_world * glm::vec4(center, 1.0f);
+			bounds.extent = glm::vec3(0.0f);
+			for (uint32_t c = 0; c < 3; ++c) {
+				bounds.extent += glm::abs(object_to_world[c]) * extent[c];
+			}
+			bounds.transform_version = drawable->transform->cache.version;
+		}
+		cull_boxes.push_back(bounds.center, bounds.extent);
+		cull_candidates.emplace_back(drawable.get());
+	}
+
+	Frustum(world_to_clip).test(cull_boxes, cull_inside);
+	for (size_t i = 0; i < cull_candidates.size(); ++i) {
+		if (cull_inside[i]) visible.drawables.emplace_back(cull_candidates[i]);
+	}
+}
+
+uint64_t Scene::static_shadow_signature() const {
+	//FNV-1a-style mix of everything about the static casters that shows up in their shadows:
+	uint64_t signature = 14695981039346656037ull;
+	auto mix = [&signature](uint64_t value) {
+		signature = (signature ^ value) * 1099511628211ull;
+	};
+	for (auto const &drawable : drawables) {
+		if (drawable->dynamic || drawable->ignore_shadow) continue;
+		mix(uint64_t(reinterpret_cast< uintptr_t >(drawable.get())));
+		//(update_transforms() only gives a transform a new cache version when it or a parent moved)
+		mix(drawable->transform->cache.version);
+		mix(drawable->wireframe_info.draw_frame);
+	}
+	return signature;
+}
+
+//distance of a drawable's origin along the view direction (clip-space w):
+static float view_depth(glm::mat4 const &world_to_clip, glm::mat4x3 const &object_to_world) {
+	glm::vec3 const &origin = object_to_world[3];
+	return world_to_clip[0][3] * origin.x + world_to_clip[1][3] * origin.y + world_to_clip[2][3] * origin.z + world_to_clip[3][3];
+}
+
+//the static batch a drawable is drawn with, if any (not once it's flagged dynamic, nor before the batches are uploaded):
+static Scene::StaticBatches::Batch const *static_batch_of(Scene::StaticBatches const *batches, Scene::Drawable const &drawable) {
+	if (!batches || !batches->ready() || drawable.static_batch.batch < 0 || drawable.dynamic) return nullptr;
+	return &batches->batches[drawable.static_batch.batch];
+}
+
+void Scene::draw_shadow(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, Visible const *visible) const
 {
-    for (auto const &drawable: drawables)
+    //the shadow map's clip space is light space, so that's the volume to cull by:
+    if (!visible) {
+        cull(glm::mat4(world_to_light), culled);
+        visible = &culled;
+    }
+
+    //one program for everything, so sort by wireframe-ness (its one per-drawable mode uniform), then
+    // vertex array, then front-to-back:
+    render_queue.clear();
+    queued_drawables.clear();
+    for (Drawable const *drawable : visible->drawables)
     {
-        if (drawable->wireframe_info.draw_frame != draw_frame || drawable->ignore_shadow) {
+        if (drawable->ignore_shadow) {
             continue;
         }
+        assert(drawable->transform); //drawables *must* have a transform
+        Scene::Drawable::Pipeline const &pipeline = *drawable->pipeline;
+        float depth = view_depth(world_to_clip, drawable->transform->make_local_to_world());
+        //(static batch members are keyed by their batch, so each batch's members end up next to each other)
+        StaticBatches::Batch const *batch = static_batch_of(static_batches.get(), *drawable);
+        uint64_t key = RenderQueue::make_key(0, drawable->wireframe_info.draw_frame ? 1 : 0,
+            render_queue.vaos(batch ? batch->pipeline.vao : pipeline.vao),
+            0, batch ? render_queue.meshes(uint64_t(drawable->static_batch.batch)) + 1 : 0, depth);
+        render_queue.add(key, uint32_t(queued_drawables.size()));
+        queued_drawables.emplace_back(drawable);
+    }
+    render_queue.sort();
 
-        glUseProgram(shadow_map_program_pipeline.program);
-
-        Scene::Drawable::Pipeline const &pipeline = drawable->pipeline;
+    //the world-to-light matrix is the same for every draw, so it goes in the Camera block:
+    UniformBlocks::set_camera(world_to_clip, world_to_light);
 
-        glBindVertexArray(pipeline.vao);
+    RenderQueue::State &state = render_queue.state;
+    state.use_program(shadow_map_program_pipeline.program);
+    int wireframe = -1;
+    for (size_t i = 0; i < render_queue.items.size(); )
+    {
+        Drawable const *drawable = queued_drawables[render_queue.items[i].index];
+        Scene::Drawable::Pipeline const &pipeline = *drawable->pipeline;
 
+        if (wireframe != int(drawable->wireframe_info.draw_frame)) {
+            wireframe = int(drawable->wireframe_info.draw_frame);
+            glUniform1i(shadow_map_program_pipeline.draw_frame, wireframe);
+        }
 
-        assert(drawable->transform); //drawables *must* have a transform
-        glm::mat4x3 object_to_world = drawable->transform->make_local_to_world();
+        //a run of members of one static batch is one glMultiDrawArrays (as in draw()):
+        if (StaticBatches::Batch const *batch = static_batch_of(static_batches.get(), *drawable)) {
+            batch_firsts.clear();
+            batch_counts.clear();
+            size_t run = 0;
+            while (i + run < render_queue.items.size()) {
+                Drawable const *member = queued_drawables[render_queue.items[i + run].index];
+                if (static_batch_of(static_batches.get(), *member) != batch) break;
+                if (member->wireframe_info.draw_frame != drawable->wireframe_info.draw_frame) break;
+                batch_firsts.emplace_back(member->static_batch.first);
+                batch_counts.emplace_back(GLsizei(member->pipeline->count));
+                run += 1;
+            }
+            state.bind_vertex_array(batch->pipeline.vao);
+            glm::mat4x3 identity = glm::mat4x3(1.0f); //(batches are in world space already)
+            glUniformMatrix4x3fv(shadow_map_program_pipeline.OBJECT_TO_WORLD_mat4x3, 1, GL_FALSE,
+                                 glm::value_ptr(identity));
+            glMultiDrawArrays(batch->pipeline.type, batch_firsts.data(), batch_counts.data(), GLsizei(run));
+            i += run;
+            continue;
+        }
+        i += 1;
 
-        glm::mat4x3 object_to_light = world_to_light * glm::mat4(object_to_world);
+        state.bind_vertex_array(pipeline.vao);
 
-        glUniformMatrix4x3fv(shadow_map_program_pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE,
-                             glm::value_ptr(object_to_light));
-        glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
-        glUniformMatrix4fv(shadow_map_program_pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE,
-                           glm::value_ptr(object_to_clip));
+        glm::mat4x3 object_to_world = drawable->transform->make_local_to_world();
+        glUniformMatrix4x3fv(shadow_map_program_pipeline.OBJECT_TO_WORLD_mat4x3, 1, GL_FALSE,
+                             glm::value_ptr(object_to_world));
 
         glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
     }
 
-    glUseProgram(0);
-    glBindVertexArray(0);
+    state.reset();
 
     GL_ERRORS();
 }
 
-void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, bool draw_frame) const {
-    // Draw the scene
+GLuint Scene::instance_buffer() {
+	static GLuint buffer = 0;
+	if (buffer == 0) {
+		glGenBuffers(1, &buffer);
+	}
+	return buffer;
+}
+
+Scene::StaticBatches::StaticBatches(std::vector< MeshBuffer::Vertex > &&vertices_, std::vector< Mesh > const &ranges)
+	: vertices(std::move(vertices_), ranges, MeshBuffer::DeferUpload()) {
+}
+
+Scene::StaticBatches::~StaticBatches() {
+	for (GLuint vao : vaos) {
+		glDeleteVertexArrays(1, &vao);
+	}
+}
+
+//a transform's local-to-world matrix, composed from its (and its parents') members without reading or
+// writing the cached ones (so it's safe on a loading thread):
+static glm::mat4x3 uncached_local_to_world(Scene::Transform const &transform) {
+	glm::mat4x3 local_to_world = transform.make_local_to_parent();
+	for (Scene::Transform const *p = transform.parent; p; p = p->parent) {
+		local_to_world = p->make_local_to_parent() * glm::mat4(local_to_world);
+	}
+	return local_to_world;
+}
+
+void Scene::build_static_batches(MeshBuffer const &meshes) {
+	MeshBuffer::Vertex const *source = meshes.vertices();
+	if (!source) {
+		throw std::runtime_error("Building static batches from a MeshBuffer that has already been uploaded.");
+	}
+
+	//group drawables by everything a batch's members share (their "material"):
+	struct Group {
+		StaticBatches::Batch batch;
+		std::vector< Drawable * > members;
+	};
+	std::vector< Group > groups;
 	for (auto const &drawable : drawables) {
-		if (drawable->is_invisible){
-			continue;
+		if (drawable->dynamic) continue;
+		Drawable::Pipeline const &pipeline = *drawable->pipeline;
+		if (pipeline.program == 0 || pipeline.count == 0) continue;
+
+		auto same_group = [&](Group const &group) {
+			StaticBatches::Batch const &batch = group.batch;
+			if (batch.pipeline.program != pipeline.program || batch.pipeline.type != pipeline.type) return false;
+			for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
+				if (batch.pipeline.textures[i].texture != pipeline.textures[i].texture
+				 || batch.pipeline.textures[i].target != pipeline.textures[i].target) return false;
+			}
+			return batch.specular_brightness == drawable->specular_info.specular_brightness
+				&& batch.shininess == drawable->specular_info.shininess;
+		};
+		auto group = std::find_if(groups.begin(), groups.end(), same_group);
+		if (group == groups.end()) {
+			groups.emplace_back();
+			group = groups.end() - 1;
+			group->batch.pipeline = pipeline;
+			group->batch.pipeline.vao = 0; //(made by upload_static_batches)
+			group->batch.specular_brightness = drawable->specular_info.specular_brightness;
+			group->batch.shininess = drawable->specular_info.shininess;
 		}
+		group->members.emplace_back(drawable.get());
+	}
 
-		if (drawable->wireframe_info.draw_frame != draw_frame){
+	//copy the vertices of groups with more than one member, transformed to world space:
+	std::vector< MeshBuffer::Vertex > vertices;
+	std::vector< Mesh > ranges;
+	std::vector< StaticBatches::Batch > batches;
+	for (Group &group : groups) {
+		if (group.members.size() < 2) continue;
+		for (Drawable *member : group.members) {
+			Drawable::Pipeline const &pipeline = *member->pipeline;
+			glm::mat4x3 object_to_world = uncached_local_to_world(*member->transform);
+			//(like NORMAL_TO_LIGHT in draw(), so the shaders see the same normals as when drawn on its own)
+			glm::mat3 normal_to_world = glm::inverse(glm::transpose(glm::mat3(object_to_world)));
+
+			Mesh range;
+			range.type = pipeline.type;
+			range.start = GLuint(vertices.size());
+			range.count = pipeline.count;
+			ranges.emplace_back(range);
+
+			member->static_batch.batch = int32_t(batches.size());
+			member->static_batch.first = GLint(range.start);
+			for (GLuint v = pipeline.start; v < pipeline.start + pipeline.count; ++v) {
+				vertices.emplace_back(source[v]);
+				MeshBuffer::Vertex &vertex = vertices.back();
+				vertex.Position = object_to_world * glm::vec4(vertex.Position, 1.0f);
+				vertex.Normal = normal_to_world * vertex.Normal;
+			}
+		}
+		batches.emplace_back(std::move(group.batch));
+	}
+
+	if (batches.empty()) {
+		static_batches.reset();
+		return;
+	}
+	static_batches = std::make_shared< StaticBatches >(std::move(vertices), ranges);
+	static_batches->batches = std::move(batches);
+}
+
+bool Scene::upload_static_batches(size_t max_bytes) {
+	if (!static_batches || static_batches->ready()) return true;
+	StaticBatches &batches = *static_batches;
+	if (!batches.vertices.upload(max_bytes)) return false;
+
+	//one vertex array per program, shared by its batches:
+	std::unordered_map< GLuint, GLuint > program_vaos;
+	for (StaticBatches::Batch &batch : batches.batches) {
+		auto f = program_vaos.find(batch.pipeline.program);
+		if (f == program_vaos.end()) {
+			GLuint vao = batches.vertices.make_vao_for_program(batch.pipeline.program);
+			batches.vaos.emplace_back(vao);
+			f = program_vaos.emplace(batch.pipeline.program, vao).first;
+		}
+		batch.pipeline.vao = f->second;
+	}
+	GL_ERRORS();
+	return true;
+}
+
+//can draws with these two pipelines be combined into one instanced draw?
+// (everything but the per-instance transform and specular info has to match)
+static bool same_instanced_draw(Scene::Drawable::Pipeline const &a, Scene::Drawable::Pipeline const &b) {
+	if (a.program != b.program || a.vao != b.vao) return false;
+	if (a.instanced.program != b.instanced.program || a.instanced.vao != b.instanced.vao) return false;
+	if (a.type != b.type || a.start != b.start || a.count != b.count) return false;
+	for (uint32_t i = 0; i < Scene::Drawable::Pipeline::TextureCount; ++i) {
+		if (a.textures[i].texture != b.textures[i].texture || a.textures[i].target != b.textures[i].target) return false;
+	}
+	return true;
+}
+
+void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light, Visible const *visible) const {
+	if (!visible) {
+		cull(world_to_clip, culled);
+		visible = &culled;
+	}
+
+	//queue up the visible drawables, keyed by the state they need:
+	render_queue.clear();
+	queued_drawables.clear();
+	for (Drawable const *drawable : visible->drawables) {
+		if (drawable->is_invisible){
 			continue;
 		}
 
 		//Reference to drawable's pipeline for convenience:
-		Scene::Drawable::Pipeline const &pipeline = drawable->pipeline;
+		Scene::Drawable::Pipeline const &pipeline = *drawable->pipeline;
 
 		//skip any drawables without a shader program set:
 		if (pipeline.program == 0) continue;
@@ -154,23 +522,72 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 		//skip any drawables that don't contain any vertices:
 		if (pipeline.count == 0) continue;
 
+		assert(drawable->transform); //drawables *must* have a transform
 
-		//Set shader program:
-		glUseProgram(pipeline.program);
+		//(texture names packed into one value; a collision only affects ordering, not what gets bound)
+		uint64_t texture_set = 0;
+		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
+			texture_set |= uint64_t(pipeline.textures[i].texture & 0xffff) << (16 * i);
+		}
+
+		//(members of a static batch are keyed by their batch, so each batch's members end up next to each other)
+		StaticBatches::Batch const *batch = static_batch_of(static_batches.get(), *drawable);
+		uint64_t key = RenderQueue::make_key(0,
+			render_queue.programs(pipeline.program),
+			render_queue.vaos(batch ? batch->pipeline.vao : pipeline.vao),
+			render_queue.texture_sets(texture_set),
+			render_queue.meshes(batch ? (1ull << 63) | uint64_t(drawable->static_batch.batch) : (uint64_t(pipeline.start) << 32) | pipeline.count),
+			view_depth(world_to_clip, drawable->transform->make_local_to_world()));
+		render_queue.add(key, uint32_t(queued_drawables.size()));
+		queued_drawables.emplace_back(drawable);
+	}
+	render_queue.sort();
+
+	//camera matrices for the programs that read them from the Camera block (instanced variants):
+	UniformBlocks::set_camera(world_to_clip, world_to_light);
+
+	//draw in key order, only changing the state that differs from the previous draw:
+	RenderQueue::State &state = render_queue.state;
+	glm::vec3 specular_brightness = glm::vec3(0.0f);
+	float specular_shininess = 0.0f;
+	int wireframe = -1; //current program's 'wireframe' uniform (-1: not set since the program changed)
+	auto set_wireframe = [&wireframe](GLuint location, bool draw_frame) {
+		if (location != -1U && wireframe != int(draw_frame)) {
+			glUniform1i(location, draw_frame);
+			wireframe = int(draw_frame);
+		}
+	};
+	auto bind_textures = [&state](Scene::Drawable::Pipeline const &pipeline) {
+		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
+			if (pipeline.textures[i].texture != 0) {
+				state.bind_texture(i, pipeline.textures[i].target, pipeline.textures[i].texture);
+			}
+		}
+	};
+	//state for one (non-instanced) draw with 'pipeline' (a drawable's, or a static batch's):
+	auto prepare_draw = [&](Scene::Drawable::Pipeline const &pipeline, glm::mat4x3 const &object_to_world,
+		glm::vec3 const &brightness, float shininess, bool draw_frame) {
+
+		//Set shader program (and the uniforms that are the same for its whole run of draws):
+		if (state.use_program(pipeline.program)) {
+			wireframe = -1;
+
+			//set any requested custom uniforms:
+			// (these are per-program settings like lighting, so once per program change is enough)
+			if (pipeline.set_uniforms) pipeline.set_uniforms();
+
+			specular_brightness = brightness;
+			specular_shininess = shininess;
+			glUniform3fv(pipeline.SPECULAR_BRIGHTNESS_vec3, 1, glm::value_ptr(specular_brightness));
+			glUniform1f(pipeline.SPECULAR_SHININESS_float, specular_shininess);
+		}
+		set_wireframe(pipeline.draw_frame, draw_frame);
 
 		//Set attribute sources:
-		glBindVertexArray(pipeline.vao);
+		state.bind_vertex_array(pipeline.vao);
 
 		//Configure program uniforms:
 
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable->transform); //drawables *must* have a transform
-		glm::mat4x3 object_to_world = drawable->transform->make_local_to_world();
-
-		if(pipeline.draw_frame != -1U){
-			glUniform1i(pipeline.draw_frame,draw_frame);
-		}
-
 		//OBJECT_TO_CLIP takes vertices from object space to clip space:
 		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
 			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
@@ -191,37 +608,95 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 			glUniformMatrix3fv(pipeline.NORMAL_TO_LIGHT_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_light));
 		}
 
-        //set any requested custom uniforms:
-		if (pipeline.set_uniforms) pipeline.set_uniforms();
-
-        // Specular info
-        glUniform3fv(pipeline.SPECULAR_BRIGHTNESS_vec3, 1, glm::value_ptr(drawable->specular_info.specular_brightness));
-        glUniform1f(pipeline.SPECULAR_SHININESS_float, drawable->specular_info.shininess);
+        // Specular info (only when it differs from the previous draw's):
+        if (brightness != specular_brightness) {
+            specular_brightness = brightness;
+            glUniform3fv(pipeline.SPECULAR_BRIGHTNESS_vec3, 1, glm::value_ptr(specular_brightness));
+        }
+        if (shininess != specular_shininess) {
+            specular_shininess = shininess;
+            glUniform1f(pipeline.SPECULAR_SHININESS_float, specular_shininess);
+        }
 
         //set up textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, pipeline.textures[i].texture);
+		bind_textures(pipeline);
+	};
+	for (size_t i = 0; i < render_queue.items.size(); ) {
+		Drawable const *drawable = queued_drawables[render_queue.items[i].index];
+		Scene::Drawable::Pipeline const &pipeline = *drawable->pipeline;
+
+		//a run of members of one static batch (sorting put them next to each other) is drawn with one
+		// glMultiDrawArrays over their vertex copies; members drawn as wireframes get a run of their own:
+		if (StaticBatches::Batch const *batch = static_batch_of(static_batches.get(), *drawable)) {
+			batch_firsts.clear();
+			batch_counts.clear();
+			size_t run = 0;
+			while (i + run < render_queue.items.size()) {
+				Drawable const *member = queued_drawables[render_queue.items[i + run].index];
+				if (static_batch_of(static_batches.get(), *member) != batch) break;
+				if (member->wireframe_info.draw_frame != drawable->wireframe_info.draw_frame) break;
+				batch_firsts.emplace_back(member->static_batch.first);
+				batch_counts.emplace_back(GLsizei(member->pipeline->count));
+				run += 1;
 			}
+			prepare_draw(batch->pipeline, glm::mat4x3(1.0f), batch->specular_brightness, batch->shininess,
+				drawable->wireframe_info.draw_frame);
+			glMultiDrawArrays(batch->pipeline.type, batch_firsts.data(), batch_counts.data(), GLsizei(run));
+			i += run;
+			continue;
 		}
 
-		//draw the object:
-		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
-
-		//un-bind textures:
-		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
-			if (pipeline.textures[i].texture != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(pipeline.textures[i].target, 0);
+		//a run of draws that differ only in transform and specular info (sorting put them next to
+		// each other) is drawn as one instanced draw, if the pipeline has an instanced variant:
+		size_t run = 1;
+		if (pipeline.instanced.program != 0 && pipeline.instanced.vao != 0) {
+			while (i + run < render_queue.items.size()) {
+				Drawable const *next = queued_drawables[render_queue.items[i + run].index];
+				if (!same_instanced_draw(pipeline, *next->pipeline)) break;
+				if (next->wireframe_info.draw_frame != drawable->wireframe_info.draw_frame) break;
+				if (static_batch_of(static_batches.get(), *next)) break;
+				run += 1;
+			}
+		}
+		if (run > 1) {
+			if (state.use_program(pipeline.instanced.program)) {
+				wireframe = -1;
+				if (pipeline.instanced.set_uniforms) pipeline.instanced.set_uniforms();
 			}
+			set_wireframe(pipeline.instanced.draw_frame, drawable->wireframe_info.draw_frame);
+
+			instances.clear();
+			for (size_t r = i; r < i + run; ++r) {
+				Drawable const *instance = queued_drawables[render_queue.items[r].index];
+				instances.emplace_back(MeshBuffer::Instance{
+					instance->transform->make_local_to_world(),
+					glm::vec4(instance->specular_info.specular_brightness, instance->specular_info.shininess)
+				});
+			}
+			//(re-specifying the whole buffer lets the driver hand out fresh storage instead of waiting on earlier draws)
+			glBindBuffer(GL_ARRAY_BUFFER, instance_buffer());
+			glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(MeshBuffer::Instance), instances.data(), GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			state.bind_vertex_array(pipeline.instanced.vao);
+			bind_textures(pipeline);
+
+			glDrawArraysInstanced(pipeline.type, pipeline.start, pipeline.count, GLsizei(run));
+			i += run;
+			continue;
 		}
-		glActiveTexture(GL_TEXTURE0);
+		i += 1;
+
+		prepare_draw(pipeline, drawable->transform->make_local_to_world(),
+			drawable->specular_info.specular_brightness, drawable->specular_info.shininess,
+			drawable->wireframe_info.draw_frame);
 
+		//draw the object:
+		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
 	}
 
-	glUseProgram(0);
-	glBindVertexArray(0);
+	//un-bind textures, program, and vertex array:
+	state.reset();
 
 	GL_ERRORS();
 }
@@ -230,10 +705,9 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 void Scene::load(std::string const &filename,
 	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
 
-	std::ifstream file(filename, std::ios::binary);
+	ChunkReader file(filename);
 
-	std::vector< char > names;
-	read_chunk(file, "str0", &names);
+	ChunkSpan< char > names = file.read< char >("str0");
 
 	struct HierarchyEntry {
 		uint32_t parent;
@@ -244,8 +718,7 @@ void Scene::load(std::string const &filename,
 		glm::vec3 scale;
 	};
 	static_assert(sizeof(HierarchyEntry) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "HierarchyEntry is packed.");
-	std::vector< HierarchyEntry > hierarchy;
-	read_chunk(file, "xfh0", &hierarchy);
+	ChunkSpan< HierarchyEntry > hierarchy = file.read< HierarchyEntry >("xfh0");
 
 	struct MeshEntry {
 		uint32_t transform;
@@ -253,8 +726,7 @@ void Scene::load(std::string const &filename,
 		uint32_t name_end;
 	};
 	static_assert(sizeof(MeshEntry) == 4 + 4 + 4, "MeshEntry is packed.");
-	std::vector< MeshEntry > meshes;
-	read_chunk(file, "msh0", &meshes);
+	ChunkSpan< MeshEntry > meshes = file.read< MeshEntry >("msh0");
 
 	struct CameraEntry {
 		uint32_t transform;
@@ -263,8 +735,7 @@ void Scene::load(std::string const &filename,
 		float clip_near, clip_far;
 	};
 	static_assert(sizeof(CameraEntry) == 4 + 4 + 4 + 4 + 4, "CameraEntry is packed.");
-	std::vector< CameraEntry > loaded_cameras;
-	read_chunk(file, "cam0", &loaded_cameras);
+	ChunkSpan< CameraEntry > loaded_cameras = file.read< CameraEntry >("cam0");
 
 	struct LightEntry {
 		uint32_t transform;
@@ -275,8 +746,7 @@ void Scene::load(std::string const &filename,
 		float fov;
 	};
 	static_assert(sizeof(LightEntry) == 4 + 1 + 3 + 4 + 4 + 4, "LightEntry is packed.");
-	std::vector< LightEntry > loaded_lights;
-	read_chunk(file, "lmp0", &loaded_lights);
+	ChunkSpan< LightEntry > loaded_lights = file.read< LightEntry >("lmp0");
 
 
 	//--------------------------------
@@ -295,11 +765,7 @@ void Scene::load(std::string const &filename,
 			t->parent = hierarchy_transforms[h.parent];
 		}
 
-		if (h.name_begin <= h.name_end && h.name_end <= names.size()) {
-			t->name = std::string(names.begin() + h.name_begin, names.begin() + h.name_end);
-		} else {
-				throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
-		}
+		t->name = std::string(file.string(names, h.name_begin, h.name_end));
 
 		t->position = h.position;
 		t->rotation = h.rotation;
@@ -313,10 +779,7 @@ void Scene::load(std::string const &filename,
 		if (m.transform >= hierarchy_transforms.size()) {
 			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid transform index (" + std::to_string(m.transform) + ")");
 		}
-		if (!(m.name_begin <= m.name_end && m.name_end <= names.size())) {
-			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid name indices");
-		}
-		std::string name = std::string(names.begin() + m.name_begin, names.begin() + m.name_end);
+		std::string name = std::string(file.string(names, m.name_begin, m.name_end));
 
 		if (on_drawable) {
 			on_drawable(*this, hierarchy_transforms[m.transform], name);
@@ -366,7 +829,7 @@ void Scene::load(std::string const &filename,
 	//load any extra that a subclass wants:
 	load_extra(file, names, hierarchy_transforms);
 
-	if (file.peek() != EOF) {
+	if (!file.at_end()) {
 		std::cerr << "WARNING: trailing data in scene file '" << filename << "'" << std::endl;
 	}
 
@@ -389,54 +852,79 @@ Scene &Scene::operator=(Scene const &other) {
 	return *this;
 }
 
-void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map_) {
-
-	std::unordered_map< Transform const *, Transform * > t2t_temp;
-	std::unordered_map< Transform const *, Transform * > &transform_to_transform = *(transform_map_ ? transform_map_ : &t2t_temp);
-
-	transform_to_transform.clear();
+void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map) {
 
-	//null transform maps to itself:
-	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
-
-	//Copy transforms and store mapping:
+	//Copy transforms, pairing each of other's transforms with its copy (sorted by other's pointers, so
+	// everything below can find a copy by binary search, without writing to other):
 	transforms.clear();
+	hierarchy_nodes.clear(); //(pointed into the old transforms)
+	std::vector< std::pair< Transform const *, Transform * > > new_transforms;
+	new_transforms.reserve(other.transforms.size());
 	for (auto const &t : other.transforms) {
 		transforms.emplace_back();
-		transforms.back().name = t.name;
-		transforms.back().position = t.position;
-		transforms.back().rotation = t.rotation;
-		transforms.back().scale = t.scale;
-		transforms.back().parent = t.parent; //will update later
-
-		//store mapping between transforms old and new:
-		auto ret = transform_to_transform.insert(std::make_pair(&t, &transforms.back()));
-		assert(ret.second);
+		Transform &copy = transforms.back();
+		copy.name = t.name;
+		copy.position = t.position;
+		copy.rotation = t.rotation;
+		copy.scale = t.scale;
+		new_transforms.emplace_back(&t, &copy);
 	}
+	std::sort(new_transforms.begin(), new_transforms.end());
+
+	auto lookup = [&new_transforms](Transform const *t) -> Transform * {
+		if (!t) return nullptr;
+		auto f = std::lower_bound(new_transforms.begin(), new_transforms.end(), t,
+			[](std::pair< Transform const *, Transform * > const &a, Transform const *b) { return a.first < b; });
+		assert(f != new_transforms.end() && f->first == t);
+		return f->second;
+	};
 
 	//update transform parents:
-	for (auto &t : transforms) {
-		t.parent = transform_to_transform.at(t.parent);
+	{
+		auto t = transforms.begin();
+		for (auto const &o : other.transforms) {
+			t->parent = lookup(o.parent);
+			++t;
+		}
 	}
 
-	//copy other's drawables, updating transform pointers:
-	drawables = other.drawables;
-	for (auto &d : drawables) {
-		d->transform = transform_to_transform.at(d->transform);
+	if (transform_map) {
+		transform_map->clear();
+		transform_map->insert(std::make_pair(nullptr, nullptr));
+		transform_map->insert(new_transforms.begin(), new_transforms.end());
+	}
+
+	//copy other's drawables (sharing their pipelines), updating transform pointers:
+	drawables.clear();
+	for (auto const &d : other.drawables) {
+		drawables.emplace_back(std::make_shared< Drawable >(*d));
+		drawables.back()->transform = lookup(d->transform);
 	}
 
 	//copy other's cameras, updating transform pointers:
 	cameras = other.cameras;
-        cams = other.cams;
 	for (auto &c : cameras) {
-		c.transform = transform_to_transform.at(c.transform);
+		c.transform = lookup(c.transform);
+	}
+	//(cams points at cameras, so it is rebuilt to point at our copies:)
+	cams.clear();
+	{
+		auto c = cameras.begin();
+		for (auto const &o : other.cameras) {
+			for (auto const &[name, camera] : other.cams) {
+				if (camera == &o) cams[name] = &*c;
+			}
+			++c;
+		}
 	}
 
 	//copy other's lights, updating transform pointers:
 	lights = other.lights;
 	for (auto &l : lights) {
-		l.transform = transform_to_transform.at(l.transform);
+		l.transform = lookup(l.transform);
 	}
+	//(static batches are shared; drawables' static_batch indices were copied with them)
+	static_batches = other.static_batches;
 }
 
 
@@ -652,28 +1140,37 @@ std::pair<int, float> Scene::Collider::least_collison_axis(std::shared_ptr<Scene
 // on means draw full color at first
 // check if there is a prefix_on(off)_(onetime)_xxxxx_invisible
 void Scene::initialize_wireframe_objects(const std::string &prefix) {
+    NameIndex &names = NameIndex::get();
+    NameIndex::Tag const wire_tag = names.tag(prefix);
+    NameIndex::Tag const pass_tag = names.tag("_pass");
+    NameIndex::Tag const block_tag = names.tag("_block");
+    NameIndex::Tag const onetime_tag = names.tag("_onetime");
+    NameIndex::Tag const on_tag = names.tag("_on_");
+    
     for (const auto &c: colliders) {
-        if (c->name.find(prefix) != std::string::npos) {
+        if (c->has_tag(wire_tag)) {
             wireframe_objects.push_back(c);
             // Only one time?
             auto d = drawble_name_map[c->name];
             
-            if (c->name.find("_pass") != std::string::npos) {
+            if (c->has_tag(pass_tag)) {
                 //wf_obj_pass.push_back(c);
                 wf_obj_pass_map[c->name] = c;
-            } else if (c->name.find("_block") != std::string::npos) {
+            } else if (c->has_tag(block_tag)) {
                 //wf_obj_block.push_back(c);
                 wf_obj_block_map[c->name] = c;
             } else {
                 throw std::runtime_error("Unknown type of wireframe object");
             }
             
-            if (c->name.find("_onetime") != std::string::npos) {
+            d->dynamic = true; //(toggles between filled and wireframe)
+
+            if (c->has_tag(onetime_tag)) {
                 d->wireframe_info.one_time_change = true;
             } else {
                 d->wireframe_info.one_time_change = false;
             }
-            if (c->name.find("_on_") != std::string::npos) {
+            if (c->has_tag(on_tag)) {
                 d->wireframe_info.draw_frame = false;
             } else {
                 d->wireframe_info.draw_frame = true;
@@ -719,18 +1216,29 @@ void Scene::initialize_scene_metadata() {
 
 // Which mesh to lookup?
 // prefix_xxxxx
-void Scene::initialize_collider(const std::string &prefix, Load<MeshBuffer> meshes) {
-    for (const auto &it: meshes->meshes) {
-        const std::string &name = it.first;
-        auto mesh = it.second;
-        if (name.find(prefix) != std::string::npos || name == "Player") {
-            glm::vec3 min = mesh.min;
-            glm::vec3 max = mesh.max;
+void Scene::initialize_collider(const std::string &prefix, MeshBuffer const &meshes) {
+    NameIndex &names = NameIndex::get();
+    NameIndex::Tag const terminal_tag = names.tag("col_terminal");
+    
+    //the meshes named with prefix, plus the player (kept in id order):
+    std::vector<NameIndex::Id> ids = names.tagged(names.tag(prefix));
+    NameIndex::Id player_id = names.find("Player");
+    if (player_id != NameIndex::Invalid && !std::binary_search(ids.begin(), ids.end(), player_id)) {
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), player_id), player_id);
+    }
+    
+    for (NameIndex::Id id: ids) {
+        Mesh const *mesh = meshes.find(id);
+        if (!mesh) continue;
+        const std::string &name = names.name(id);
+        {
+            glm::vec3 min = mesh->min;
+            glm::vec3 max = mesh->max;
             auto collider = std::make_shared<Scene::Collider>(name, min, max, min, max);
             auto d = drawble_name_map[name];
             collider->update_BBox(d->transform);
 
-			if(name.find("col_terminal") == std::string::npos){
+			if(!names.has(id, terminal_tag)){
 				colliders.push_back(collider);
 				collider_name_map[name] = collider;
 			}else{
@@ -744,13 +1252,16 @@ void Scene::initialize_collider(const std::string &prefix, Load<MeshBuffer> mesh
 }
 
 
-void Scene::initialize_text_collider(const std::string &prefix, Load<MeshBuffer> meshes) {
-    for (const auto &it: meshes->meshes) {
-        const std::string &name = it.first;
-        auto mesh = it.second;
-        if (name.find(prefix) != std::string::npos) {
-            glm::vec3 min = mesh.min;
-            glm::vec3 max = mesh.max;
+void Scene::initialize_text_collider(const std::string &prefix, MeshBuffer const &meshes) {
+    NameIndex &names = NameIndex::get();
+    //(copied, since creating colliders interns names)
+    std::vector<NameIndex::Id> const ids = names.tagged(names.tag(prefix));
+    for (NameIndex::Id id: ids) {
+        Mesh const *mesh = meshes.find(id);
+        const std::string &name = names.name(id);
+        if (mesh) {
+            glm::vec3 min = mesh->min;
+            glm::vec3 max = mesh->max;
             auto collider = std::make_shared<Scene::Collider>(name, min, max, min, max);
             auto d = drawble_name_map[name];
             if (d == nullptr) {
@@ -766,7 +1277,7 @@ void Scene::initialize_text_collider(const std::string &prefix, Load<MeshBuffer>
 
 // a pair of bread name should be bread_name_1 and bread_name_2
 // bread name must ends with _1 or _2
-void Scene::initialize_bread(const std::string &prefix, Load<MeshBuffer> meshes){
+void Scene::initialize_bread(const std::string &prefix, MeshBuffer const &meshes){
 
 	auto endsWith = [](const std::string &str, const std::string &suffix) {
 		if (str.length() < suffix.length()) {
@@ -776,13 +1287,16 @@ void Scene::initialize_bread(const std::string &prefix, Load<MeshBuffer> meshes)
 	};
 
 
-	for (const auto &it: meshes->meshes) {
-        const std::string &name = it.first;
-        auto mesh = it.second;
-        if (name.find(prefix) != std::string::npos) {
+	NameIndex &names = NameIndex::get();
+	//(copied, since creating colliders interns names)
+	std::vector<NameIndex::Id> const ids = names.tagged(names.tag(prefix));
+	for (NameIndex::Id id: ids) {
+        Mesh const *mesh = meshes.find(id);
+        const std::string &name = names.name(id);
+        if (mesh) {
 			if (endsWith(name,"_1")){
-				glm::vec3 min = mesh.min;
-				glm::vec3 max = mesh.max;
+				glm::vec3 min = mesh->min;
+				glm::vec3 max = mesh->max;
 				auto collider = std::make_shared<Scene::Collider>(name, min, max, min, max);
 				auto d = drawble_name_map[name];
 				if (d == nullptr) {
@@ -801,7 +1315,7 @@ void Scene::initialize_bread(const std::string &prefix, Load<MeshBuffer> meshes)
 					location_name.push_back('2');
 
 
-					auto location_mesh = meshes->lookup(location_name);
+					auto location_mesh = meshes.lookup(location_name);
 
 					auto location_drawable = drawble_name_map[location_name];
 					// set the location to be invisible
@@ -820,7 +1334,7 @@ void Scene::initialize_bread(const std::string &prefix, Load<MeshBuffer> meshes)
 					location_name.push_back('3');
 
 
-					auto location_mesh = meshes->lookup(location_name);
+					auto location_mesh = meshes.lookup(location_name);
 
 					auto location_drawable = drawble_name_map[location_name];
 					// set the location to be invisible
@@ -840,8 +1354,73 @@ void Scene::initialize_bread(const std::string &prefix, Load<MeshBuffer> meshes)
 }
 
 
+void Scene::initialize_baked(BakedScene const &baked) {
+	//map each transform to its baked record by name (a repeated name takes the next record with that name):
+	std::vector< Transform * > baked_transforms(baked.transforms.size(), nullptr);
+	for (auto &t : transforms) {
+		uint32_t index = baked.find(t.name);
+		while (index != BakedScene::Invalid && baked_transforms[index]) {
+			do {
+				index = (index + 1 < baked.transforms.size() ? index + 1 : BakedScene::Invalid);
+			} while (index != BakedScene::Invalid
+				&& baked.name(baked.transforms[index].name_begin, baked.transforms[index].name_end) != t.name);
+		}
+		if (index == BakedScene::Invalid) {
+			throw std::runtime_error("baked scene doesn't match scene (transform '" + t.name + "')");
+		}
+		baked_transforms[index] = &t;
+	}
+	if (transforms.size() != baked.transforms.size()) {
+		throw std::runtime_error("baked scene doesn't match scene (transform count)");
+	}
+
+	//the baked world matrices stand in for each transform's first refresh()
+	// (this runs on a freshly copied scene, on the thread that will draw it, before anything has moved):
+	for (uint32_t i = 0; i < baked_transforms.size(); ++i) {
+		Transform const &t = *baked_transforms[i];
+		t.cache.position = t.position;
+		t.cache.rotation = t.rotation;
+		t.cache.scale = t.scale;
+		t.cache.parent = t.parent;
+		t.cache.local_to_world = baked.transforms[i].local_to_world;
+		t.cache.world_to_local = t.make_parent_to_local();
+		for (Transform const *p = t.parent; p; p = p->parent) {
+			t.cache.world_to_local = t.cache.world_to_local * glm::mat4(p->make_parent_to_local());
+		}
+		t.cache.version = next_transform_version.fetch_add(1, std::memory_order_relaxed);
+	}
+	for (Transform const *t : baked_transforms) {
+		t->cache.parent_version = (t->parent ? t->parent->cache.version : 0);
+	}
+
+	for (auto const &b : baked.colliders) {
+		std::string name(baked.name(b.name_begin, b.name_end));
+		auto collider = std::make_shared<Scene::Collider>(name, b.min, b.max, b.min_original, b.max_original);
+		if (b.category == BakedScene::Plain) {
+			colliders.push_back(collider);
+			collider_name_map[name] = collider;
+		} else if (b.category == BakedScene::Terminal) {
+			terminals.push_back(collider);
+			terminal_name_map[name] = collider;
+		} else if (b.category == BakedScene::Text) {
+			text_colliders.push_back(collider);
+			textcollider_name_map[name] = collider;
+		} else if (b.category == BakedScene::Bread) {
+			bread_colliders.push_back(collider);
+			breadcollider_name_map[name] = collider;
+			bread_bouncelocation_map[collider] = std::make_pair(b.bounce_midpoint, b.bounce_destination);
+		}
+	}
+
+	for (uint32_t index : baked.invisible) {
+		auto f = drawble_name_map.find(baked_transforms[index]->name);
+		if (f != drawble_name_map.end()) f->second->is_invisible = true;
+	}
+}
+
+
 // prefix should be "col_wire_off_pass_ingredient_xxxx"
-// void Scene::initialize_ingredient(const std::string &prefix, Load<MeshBuffer> meshes){
+// void Scene::initialize_ingredient(const std::string &prefix, MeshBuffer const &meshes){
 
 // 	for (const auto &it: meshes->meshes) {
 //         const std::string &name = it.first;
@@ -16,10 +16,17 @@
 
 #include "Load.hpp"
 #include "Mesh.hpp"
+#include "ChunkReader.hpp"
+#include "BakedScene.hpp"
+#include "CopyOnWrite.hpp"
+#include "TransformHierarchy.hpp"
+#include "RenderQueue.hpp"
+#include "Frustum.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <limits>
 #include <list>
 #include <memory>
 #include <functional>
@@ -50,14 +57,37 @@ struct Scene {
 		// ..relative to its parent:
 		glm::mat4x3 make_local_to_parent() const;
 		glm::mat4x3 make_parent_to_local() const;
-		// ..relative to the world:
+		// ..relative to the world (cached; see below):
 		glm::mat4x3 make_local_to_world() const;
 		glm::mat4x3 make_world_to_local() const;
 
+		//The world matrices are cached along with the position/rotation/scale/parent they were built from.
+		// A transform counts as dirty when any of those differ from its cache (so setting the members
+		// directly is fine) or when its parent's matrices were rebuilt since; only then is it recomputed.
+		// refresh() brings the cache up to date (parents first); Scene::update_transforms() does it for
+		// every transform once per frame (in one sweep over a TransformHierarchy), so draws and queries
+		// afterwards only compare each ancestor's members and parent_version against its cache.
+		// NOTE: refreshing writes the cache, so don't read a transform moved this frame from several threads.
+		void refresh() const;
+
 		//since hierarchy is tracked through pointers, copy-constructing a transform  is not advised:
 		Transform(Transform const &) = delete;
 		//if we delete some constructors, we need to let the compiler know that the default constructor is still okay:
 		Transform() = default;
+
+	private:
+		friend struct Scene; //update_transforms() fills in the cache
+		struct Cache {
+			glm::vec3 position = glm::vec3(0.0f);
+			glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			glm::vec3 scale = glm::vec3(1.0f);
+			Transform const *parent = nullptr;
+			uint64_t parent_version = 0; //parent's cache.version when this was built
+			uint64_t version = 0; //unique per rebuild; 0 means never built
+			glm::mat4x3 local_to_world = glm::mat4x3(1.0f);
+			glm::mat4x3 world_to_local = glm::mat4x3(1.0f);
+		};
+		mutable Cache cache;
 	};
 
 	struct Drawable {
@@ -68,6 +98,10 @@ struct Scene {
 
         bool ignore_shadow = false;
 
+		//moves or changes how it draws at runtime (the player, wireframe objects); such drawables are
+		// drawn into the shadow map every frame, the rest only into the cached static one (see PlayMode::draw):
+		bool dynamic = false;
+
 		struct{
 			scene_type type;
 		} scene_info;
@@ -80,6 +114,25 @@ struct Scene {
 		// Hide some objects that are in the mesh but we don't want to render
 		bool is_invisible = false;
 
+		//object-space bounding box of what it draws (e.g. its Mesh's min / max), used for frustum culling;
+		// left empty (min > max), the drawable is never culled:
+		glm::vec3 bounds_min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 bounds_max = glm::vec3(-std::numeric_limits< float >::infinity());
+		bool has_bounds() const { return bounds_min.x <= bounds_max.x; }
+
+		//world-space box (center +/- extent), kept by Scene::cull() for the transform version it was computed at:
+		mutable struct {
+			glm::vec3 center = glm::vec3(0.0f);
+			glm::vec3 extent = glm::vec3(0.0f);
+			uint64_t transform_version = 0;
+		} world_bounds;
+
+		//where Scene::build_static_batches() copied its vertices to (index of its batch, or -1 if it has none,
+		// and first vertex of the copy in StaticBatches::vertices; the copy has pipeline.count vertices):
+		struct {
+			int32_t batch = -1;
+			GLint first = 0;
+		} static_batch;
 
 		//a 'Drawable' attaches attribute data to a transform:
 		Drawable(Transform *transform_) : transform(transform_) { assert(transform); }
@@ -100,6 +153,7 @@ struct Scene {
 			GLuint OBJECT_TO_CLIP_mat4 = -1U; //uniform location for object to clip space matrix
 			GLuint OBJECT_TO_LIGHT_mat4x3 = -1U; //uniform location for object to light space (== world space) matrix
 			GLuint NORMAL_TO_LIGHT_mat3 = -1U; //uniform location for normal to light space (== world space) matrix
+			GLuint OBJECT_TO_WORLD_mat4x3 = -1U; //uniform location for object to world matrix (for programs that get the rest from UniformBlocks' Camera block)
             GLuint SPECULAR_BRIGHTNESS_vec3 = -1U;
             GLuint SPECULAR_SHININESS_float = -1U;
 
@@ -107,13 +161,25 @@ struct Scene {
 
 			std::function< void() > set_uniforms; //(optional) function to set any other useful uniforms
 
+			//(optional) instanced variant of 'program', which draw() uses for runs of drawables sharing
+			// program, vao, mesh range and textures; it takes its object matrices and specular info per
+			// instance (MeshBuffer::Instance) instead of as uniforms, and the camera from UniformBlocks:
+			struct {
+				GLuint program = 0; //0 means no instanced variant
+				GLuint vao = 0; //made with MeshBuffer::make_vao_for_program(program, Scene::instance_buffer())
+				GLuint draw_frame = -1U;
+				std::function< void() > set_uniforms;
+			} instanced;
+
 			//texture objects to bind for the first TextureCount textures:
 			enum : uint32_t { TextureCount = 4 };
 			struct TextureInfo {
 				GLuint texture = 0;
 				GLenum target = GL_TEXTURE_2D;
 			} textures[TextureCount];
-		} pipeline;
+		};
+		//shared with the drawables of cloned scenes until one of them changes it (use pipeline.write() to change it):
+		CopyOnWrite< Pipeline > pipeline;
 	};
 
 	struct Camera {
@@ -128,6 +194,8 @@ struct Scene {
 		float near = 0.01f; //near plane
 		//computed from the above:
 		glm::mat4 make_projection() const;
+		//projection * world-to-local:
+		glm::mat4 make_world_to_clip() const;
 	};
 
 	struct Light {
@@ -155,13 +223,19 @@ struct Scene {
 	struct Collider{
 
 		std::string name;
+		//name's id in NameIndex::get(), for classifying colliders by naming-convention tags:
+		NameIndex::Id name_id = NameIndex::Invalid;
 
 		Collider(std::string name, glm::vec3 min, glm::vec3 max, glm::vec3 min_o, glm::vec3 max_o): min_original(min_o),max_original(max_o) {
 			this->min = min;
 			this->max = max;
 			this->name = name;
+			this->name_id = NameIndex::get().intern(name);
 		}
 
+		//does the collider's name contain the tag's substring? (just a bit test)
+		bool has_tag(NameIndex::Tag tag) const { return NameIndex::get().has(name_id, tag); }
+
 		const glm::vec3 min_original = glm::vec3( std::numeric_limits< float >::infinity());
 		const glm::vec3 max_original = glm::vec3( std::numeric_limits< float >::infinity());
 
@@ -230,14 +304,99 @@ struct Scene {
 	std::map<std::string,std::shared_ptr<Collider>> terminal_name_map;
 
 
+	//Frustum culling -- the drawables whose bounds touch a view's clip volume:
+	// (cull once per view per frame and hand the result to every draw() / draw_shadow() from that view)
+	struct Visible {
+		std::vector< Drawable const * > drawables;
+	};
+	enum CullFilter { AllDrawables, StaticDrawables, DynamicDrawables }; //(by Drawable::dynamic)
+	void cull(glm::mat4 const &world_to_clip, Visible &visible, CullFilter filter = AllDrawables) const;
+
+	//changes whenever something drawn into a cached static shadow map would (a static caster is
+	// added / removed / moved / toggled); compare against the value the cache was drawn at
+	// (reads the transform caches as of the last update_transforms(), without refreshing them):
+	uint64_t static_shadow_signature() const;
+
+	//the light space the Camera versions of draw() / draw_shadow() use (a fixed directional light);
+	// draw_shadow() renders (and culls) with mat4(world_to_light) as its clip transform:
+	static glm::mat4x3 default_world_to_light();
+
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
-	void draw(Camera const &camera, bool draw_frame = false) const;
+	// (if 'visible' is given, only those drawables are drawn; otherwise the scene is culled first)
+	// (filled and wireframe drawables go in the same traversal: programs with a 'wireframe' uniform
+	//  (Pipeline::draw_frame) get wireframe_info.draw_frame per draw and keep only the fragments near
+	//  triangle edges, using the mesh's Barycentric attribute -- see MeshBuffer::BarycentricGLSL)
+	// (members of static_batches are drawn a batch at a time; see StaticBatches)
+	void draw(Camera const &camera, Visible const *visible = nullptr) const;
 
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
-	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f), bool draw_frame = false) const;
-
-    void draw_shadow(Camera const &camera, bool draw_frame = false) const;
-    void draw_shadow(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f), bool draw_frame = false) const;
+	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f), Visible const *visible = nullptr) const;
+
+    void draw_shadow(Camera const &camera, Visible const *visible = nullptr) const;
+
+	//scratch for draw() / draw_shadow(): the frame's draws, sorted by state
+	mutable RenderQueue render_queue;
+	mutable std::vector< Drawable const * > queued_drawables; //RenderQueue::Item::index -> drawable
+	mutable std::vector< MeshBuffer::Instance > instances; //per-instance data of the current instanced draw
+	//scratch for cull():
+	mutable Visible culled; //(for draws not given a Visible)
+	mutable Frustum::Boxes cull_boxes;
+	mutable std::vector< uint8_t > cull_inside;
+	mutable std::vector< Drawable const * > cull_candidates;
+
+	mutable std::vector< GLint > batch_firsts; //vertex ranges of the current static batch draw
+	mutable std::vector< GLsizei > batch_counts;
+
+	//Static batching -- world-space copies of static drawables' vertices, made at load, so that draw() /
+	// draw_shadow() can draw all of a batch's visible members with one glMultiDrawArrays (and an identity
+	// object matrix) instead of a draw each. A batch's members share program, textures, primitive type and
+	// specular info -- their material -- so draws go from one per object to about one per material.
+	// (The shaders take the specular view direction from the Camera block -- see UniformBlocks -- so a
+	//  member is lit the same as when it is drawn on its own.)
+	// Culling, is_invisible and wireframe_info.draw_frame still apply per member (they pick the ranges).
+	// NOTE: members must not move; drawables flagged 'dynamic' (at any time) are drawn on their own.
+	struct StaticBatches {
+		StaticBatches(std::vector< MeshBuffer::Vertex > &&vertices, std::vector< Mesh > const &ranges);
+		~StaticBatches(); //deletes the vertex arrays
+		StaticBatches(StaticBatches const &) = delete;
+
+		MeshBuffer vertices; //(uploaded by upload_static_batches)
+		struct Batch {
+			Drawable::Pipeline pipeline; //the members' pipeline, with 'vao' reading from 'vertices' (start / count unused)
+			glm::vec3 specular_brightness = glm::vec3(0.0f);
+			float shininess = 0.0f;
+		};
+		std::vector< Batch > batches;
+		std::vector< GLuint > vaos; //one per program, made once 'vertices' is uploaded
+		bool ready() const { return !vaos.empty(); }
+	};
+	//shared by copies of this scene (nullptr if nothing was batched):
+	std::shared_ptr< StaticBatches > static_batches;
+
+	//group the (non-dynamic) drawables into static_batches, copying their vertices out of 'meshes', which must
+	// still have them in memory (e.g. a DeferUpload MeshBuffer before upload()); drawables that match no other
+	// are left alone. Makes no OpenGL calls, so it can run on a loading thread.
+	// note: will throw if 'meshes' was already uploaded
+	void build_static_batches(MeshBuffer const &meshes);
+	//upload up to max_bytes more of the batches' vertices (on the OpenGL thread), and make their vertex
+	// arrays once all are uploaded; returns true when they are ready to draw (or there are none):
+	bool upload_static_batches(size_t max_bytes = size_t(-1));
+
+	//vertex buffer that instanced draws stream their MeshBuffer::Instance data through
+	// (created on first use; Pipeline::instanced.vao should read INSTANCE_* attributes from it):
+	static GLuint instance_buffer();
+
+	//refresh every transform's cached world matrices (call once per frame, before drawing):
+	// only transforms that changed (or whose parents did) get new matrices and cache versions
+	void update_transforms();
+
+	//flattened copy of 'transforms' (parents before children) that update_transforms() sweeps over:
+	TransformHierarchy hierarchy;
+	std::vector< Transform * > hierarchy_nodes; //transform of each hierarchy node
+	std::vector< Transform const * > hierarchy_parents; //...and its parent when the order was built
+	std::vector< uint8_t > hierarchy_dirty; //scratch: which nodes update_transforms() rebuilds
+	void rebuild_hierarchy();
+    void draw_shadow(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f), Visible const *visible = nullptr) const;
 
     //add transforms/objects/cameras from a scene file to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
@@ -248,7 +407,7 @@ struct Scene {
 
 	//this function is called to read extra chunks from the scene file after the main chunks are read:
 	// this is useful if you, e.g., subclassing scene to represent a game level/area
-    void load_extra(std::istream &from, std::vector< char > const &str0, std::vector< Transform * > const &xfh0) { }
+    void load_extra(ChunkReader &from, ChunkSpan< char > const &str0, std::vector< Transform * > const &xfh0) { }
 
 	//empty scene:
 	Scene() = default;
@@ -260,6 +419,8 @@ struct Scene {
 	Scene(Scene const &); //...as a constructor
 	Scene &operator=(Scene const &); //...as scene = scene
 	//... as a set() function that optionally returns the transform->transform mapping:
+	// transforms are copied and re-parented by index (no pointer lookups); drawables are copied, but
+	// share their pipelines with 'other' until written; 'other' must not be cloned on two threads at once.
 	void set(Scene const &, std::unordered_map< Transform const *, Transform * > *transform_map = nullptr);
 
 
@@ -267,10 +428,13 @@ struct Scene {
 	void initialize_wireframe_objects(const std::string &prefix);
     void initialize_scene_metadata();
     
-    void initialize_collider(const std::string &prefix_pattern, Load<MeshBuffer> meshes);
+    void initialize_collider(const std::string &prefix_pattern, MeshBuffer const &meshes);
 
-    void initialize_text_collider(const std::string &prefix_pattern, Load<MeshBuffer> meshes);
+    void initialize_text_collider(const std::string &prefix_pattern, MeshBuffer const &meshes);
 
-	void initialize_bread(const std::string &prefix_pattern, Load<MeshBuffer> meshes);
-	//void initialize_ingredient(const std::string &prefix_pattern, Load<MeshBuffer> meshes);
+	void initialize_bread(const std::string &prefix_pattern, MeshBuffer const &meshes);
+	//the same colliders (and hidden bread locations) as initialize_collider/_text_collider/_bread, from a baked scene:
+	// note: will throw if the baked scene's transforms don't match this scene's
+	void initialize_baked(BakedScene const &baked);
+	//void initialize_ingredient(const std::string &prefix_pattern, MeshBuffer const &meshes);
 };
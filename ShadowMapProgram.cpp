@@ -4,6 +4,8 @@
 
 #include "ShadowMapProgram.hpp"
 
+#include "Mesh.hpp"
+#include "UniformBlocks.hpp"
 #include "gl_compile_program.hpp"
 #include "glm/ext.hpp"
 
@@ -15,20 +17,21 @@ Load<ShadowMapProgram> shadow_map_program(LoadTagEarly, []() -> ShadowMapProgram
     //----- build the pipeline template -----
     shadow_map_program_pipeline.program = ret->program;
 
-    shadow_map_program_pipeline.OBJECT_TO_LIGHT_mat4x3 = ret->OBJECT_TO_LIGHT_mat4x3;
-    shadow_map_program_pipeline.OBJECT_TO_CLIP_mat4 = ret->OBJECT_TO_CLIP_mat4;
+    shadow_map_program_pipeline.OBJECT_TO_WORLD_mat4x3 = ret->OBJECT_TO_WORLD_mat4x3;
+    shadow_map_program_pipeline.draw_frame = ret->draw_frame;
 
     return ret;
 });
 
 ShadowMapProgram::ShadowMapProgram() {
+    //(WORLD_TO_LIGHT comes from the shared Camera block, see UniformBlocks.hpp)
+    std::string header = std::string("#version 330\n") + UniformBlocks::GLSL;
+
     //Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
     program = gl_compile_program(
             //vertex shader:
-            "#version 330\n"
-            "uniform mat4 OBJECT_TO_CLIP;\n"
-            "uniform mat4x3 OBJECT_TO_LIGHT;\n"
-            "uniform mat3 NORMAL_TO_LIGHT;\n"
+            header + MeshBuffer::BarycentricVertexGLSL +
+            "uniform mat4x3 OBJECT_TO_WORLD;\n"
             "in vec4 Position;\n"
             "in vec3 Normal;\n"
             "in vec4 Color;\n"
@@ -38,19 +41,19 @@ ShadowMapProgram::ShadowMapProgram() {
             "out vec4 color;\n"
             "out vec2 texCoord;\n"
             "void main() {\n"
-            "	//position = OBJECT_TO_CLIP * Position;\n"
-            "	gl_Position = vec4(OBJECT_TO_LIGHT * Position, 1.0f);\n"
-            "	normal = NORMAL_TO_LIGHT * Normal;\n"
+            "	gl_Position = vec4(WORLD_TO_LIGHT * vec4(OBJECT_TO_WORLD * Position, 1.0), 1.0f);\n"
+            "	normal = mat3(OBJECT_TO_WORLD) * Normal;\n"
             "	color = Color;\n"
             "	texCoord = TexCoord;\n"
+            "	barycentric = Barycentric;\n"
             "}\n",
             //fragment shader:
-            "#version 330\n"
-            "uniform mat4 OBJECT_TO_CLIP;\n"
-            "uniform mat4x3 OBJECT_TO_LIGHT;\n"
+            header + MeshBuffer::BarycentricFragmentGLSL +
             "in vec4 color;\n"
+            "uniform bool wireframe;\n"
             "out vec4 fragColor;"
             "void main() {\n"
+            "	if (wireframe && offWireframe()) discard; //(wireframe drawables keep just their triangles' edges)\n"
             "   fragColor = color;\n"
             "}\n"
     );
@@ -61,8 +64,11 @@ ShadowMapProgram::ShadowMapProgram() {
     TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
 
     //look up the locations of uniforms:
-    OBJECT_TO_LIGHT_mat4x3 = glGetUniformLocation(program, "OBJECT_TO_LIGHT");
-    OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+    OBJECT_TO_WORLD_mat4x3 = glGetUniformLocation(program, "OBJECT_TO_WORLD");
+    draw_frame = glGetUniformLocation(program, "wireframe");
+
+    //point the uniform blocks at the shared buffers:
+    UniformBlocks::bind(program);
 }
 
 ShadowMapProgram::~ShadowMapProgram() {
@@ -17,8 +17,8 @@ struct ShadowMapProgram {
     GLuint TexCoord_vec2 = -1U;
 
     //Uniform (per-invocation variable) locations:
-    GLuint OBJECT_TO_LIGHT_mat4x3 = -1U;
-    GLuint OBJECT_TO_CLIP_mat4 = -1U;
+    GLuint OBJECT_TO_WORLD_mat4x3 = -1U; //(the world-to-light matrix is in the shared Camera block)
+    GLuint draw_frame = -1U; //"wireframe": draw only near triangle edges (see MeshBuffer::BarycentricFragmentGLSL)
 };
 
 extern Load< ShadowMapProgram > shadow_map_program;
@@ -1,5 +1,7 @@
 #include "ShadowProgram.hpp"
 
+#include "Mesh.hpp"
+#include "UniformBlocks.hpp"
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
 #include "glm/ext.hpp"
@@ -18,14 +20,15 @@ Load< ShadowProgram > shadow_program(LoadTagEarly, []() -> ShadowProgram const *
     shadow_program_pipeline.SPECULAR_BRIGHTNESS_vec3 = ret->SPECULAR_BRIGHTNESS_vec3;
     shadow_program_pipeline.SPECULAR_SHININESS_float = ret->SPECULAR_SHININESS_float;
 	shadow_program_pipeline.draw_frame = ret->draw_frame;
-    shadow_program_pipeline.set_uniforms = [ret]() {
-        glUniform1i(ret->LIGHT_TYPE_int, 1);
-        glUniform3fv(ret->LIGHT_DIRECTION_vec3, 1,
-                     glm::value_ptr(glm::normalize(glm::vec3(0.5f, 1.0f, -1.0f))));
-        glUniform3fv(ret->LIGHT_ENERGY_vec3, 1, glm::value_ptr(glm::vec3(0.6f, 0.65f, 0.7f)));
-        glUniform3fv(ret->AMBIENT_LIGHT_ENERGY_vec3, 1,
-                     glm::value_ptr(glm::vec3(0.5f, 0.45f, 0.4f)));
-    };
+
+	//this program's light rig (both variants read it through their "Light" block); set once here,
+	// since nothing changes it afterwards:
+	UniformBlocks::Light light;
+	light.LIGHT_TYPE = 1;
+	light.LIGHT_DIRECTION = glm::normalize(glm::vec3(0.5f, 1.0f, -1.0f));
+	light.LIGHT_ENERGY = glm::vec3(0.6f, 0.65f, 0.7f);
+	light.AMBIENT_LIGHT_ENERGY = glm::vec3(0.5f, 0.45f, 0.4f);
+	UniformBlocks::set_light(UniformBlocks::ShadowLightBinding, light);
 
 	//make a 1-pixel white texture to bind by default:
 	GLuint tex;
@@ -47,14 +50,34 @@ Load< ShadowProgram > shadow_program(LoadTagEarly, []() -> ShadowProgram const *
 	return ret;
 });
 
-ShadowProgram::ShadowProgram() {
+Load< ShadowProgram > shadow_program_instanced(LoadTagEarly, []() -> ShadowProgram const * {
+	ShadowProgram *ret = new ShadowProgram(true);
+
+	//----- fill in the pipeline template's instanced variant -----
+	shadow_program_pipeline.instanced.program = ret->program;
+	shadow_program_pipeline.instanced.draw_frame = ret->draw_frame;
+
+	return ret;
+});
+
+ShadowProgram::ShadowProgram(bool instanced) {
+	//the instanced variant takes per-instance transforms / specular info as attributes (see MeshBuffer::Instance);
+	//camera, frame and light values come from the shared uniform blocks (see UniformBlocks.hpp):
+	std::string header = std::string(instanced ? "#version 330\n#define INSTANCED\n" : "#version 330\n") + UniformBlocks::GLSL;
+
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
 	program = gl_compile_program(
 		//vertex shader:
-		"#version 330\n"
+		header + MeshBuffer::BarycentricVertexGLSL +
+		"#ifdef INSTANCED\n"
+		"in mat4x3 INSTANCE_TO_WORLD;\n"
+		"in vec4 INSTANCE_SPECULAR;\n"
+		"flat out vec4 instanceSpecular;\n"
+		"#else\n"
 		"uniform mat4 OBJECT_TO_CLIP;\n"
 		"uniform mat4x3 OBJECT_TO_LIGHT;\n"
 		"uniform mat3 NORMAL_TO_LIGHT;\n"
+		"#endif\n"
         "uniform sampler2D DEPTH;\n"
         "uniform sampler2D DOT;\n"
         "uniform sampler2D SHADOW_DEPTH;\n"
@@ -67,30 +90,35 @@ ShadowProgram::ShadowProgram() {
 		"out vec4 color;\n"
 		"out vec2 texCoord;\n"
 		"void main() {\n"
+		"#ifdef INSTANCED\n"
+		"	mat4 OBJECT_TO_CLIP = WORLD_TO_CLIP * mat4(INSTANCE_TO_WORLD);\n"
+		"	mat4x3 OBJECT_TO_LIGHT = WORLD_TO_LIGHT * mat4(INSTANCE_TO_WORLD);\n"
+		"	mat3 NORMAL_TO_LIGHT = inverse(transpose(mat3(OBJECT_TO_LIGHT)));\n"
+		"	instanceSpecular = INSTANCE_SPECULAR;\n"
+		"#endif\n"
 		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
 		"	position = OBJECT_TO_LIGHT * Position;\n"
 		"	normal = NORMAL_TO_LIGHT * Normal;\n"
 		"	color = Color;\n"
 		"	texCoord = TexCoord;\n"
+		"	barycentric = Barycentric;\n"
 		"}\n"
 	,
 		//fragment shader:
-		"#version 330\n"
+		header + MeshBuffer::BarycentricFragmentGLSL +
         "#define PI 3.1415926538\n"
-        "uniform mat4 OBJECT_TO_CLIP;\n"
         "uniform sampler2D TEX;\n"
         "uniform sampler2D SHADOW_DEPTH;\n"
-        "uniform int LIGHT_TYPE;\n"
-		"uniform vec3 LIGHT_LOCATION;\n"
-		"uniform vec3 LIGHT_DIRECTION;\n"
-		"uniform vec3 LIGHT_ENERGY;\n"
-        "uniform vec3 AMBIENT_LIGHT_ENERGY;\n"
+        "#ifdef INSTANCED\n"
+        "flat in vec4 instanceSpecular;\n"
+        "#define SPECULAR_SHININESS instanceSpecular.a\n"
+        "#define SPECULAR_BRIGHTNESS instanceSpecular.rgb\n"
+        "#else\n"
         "uniform float SPECULAR_SHININESS;\n"
         "uniform vec3 SPECULAR_BRIGHTNESS;\n"
-        "uniform float LIGHT_CUTOFF;\n"
+        "#endif\n"
         "uniform sampler2D DEPTH;\n"
         "uniform sampler2D DOT;\n"
-        "uniform vec4 WINDOW_DIMENSIONS;\n"
         "uniform bool COMIC_BOOK;"
         "in vec3 position;\n"
 		"in vec3 normal;\n"
@@ -99,9 +127,6 @@ ShadowProgram::ShadowProgram() {
 		"out vec4 fragColor;\n"
 		"uniform bool wireframe;\n"
         "// Code adapted from https://github.com/aehmttw/Machimania/blob/master/resources/shaders/main.frag\n"
-        "mat3 toMat3(mat4 matrix) {\n"
-        "    return mat3(matrix[0].xyz, matrix[1].xyz, matrix[2].xyz);\n"
-        "}\n"
         "float det(mat2 matrix) {\n"
         "    return matrix[0].x * matrix[1].y - matrix[0].y * matrix[1].x;\n"
         "}\n"
@@ -112,6 +137,7 @@ ShadowProgram::ShadowProgram() {
         "   return int(texture(SHADOW_DEPTH, position.xy).x < -0.001 + position.z);\n"
         "}\n"
 		"void main() {\n"
+		"	if (wireframe && offWireframe()) discard; //(wireframe drawables keep just their triangles' edges)\n"
 		"	vec3 n = normalize(normal);\n"
 		"	vec3 e;\n"
 		"	if (LIGHT_TYPE == 0) { //point light \n"
@@ -150,7 +176,7 @@ ShadowProgram::ShadowProgram() {
 		"	} else { //(LIGHT_TYPE == 3) //directional light \n"
 		"		e = max(0.0, dot(n,-LIGHT_DIRECTION)) * LIGHT_ENERGY;\n"
 		"	}\n"
-        "   vec3 cam = normalize((inverse(toMat3(OBJECT_TO_CLIP)) * vec3(0, 0, 1)).xyz);\n"
+        "   vec3 cam = VIEW_DIRECTION; //(the same for every object, however it is drawn)\n"
         "   vec3 h = normalize(cam + normalize(-LIGHT_DIRECTION));\n"
         "   float specular = pow(max(dot(n, h), 0), SPECULAR_SHININESS);\n"
         "   e += specular * SPECULAR_BRIGHTNESS;\n"
@@ -179,19 +205,14 @@ ShadowProgram::ShadowProgram() {
 	OBJECT_TO_LIGHT_mat4x3 = glGetUniformLocation(program, "OBJECT_TO_LIGHT");
 	NORMAL_TO_LIGHT_mat3 = glGetUniformLocation(program, "NORMAL_TO_LIGHT");
 
-	LIGHT_TYPE_int = glGetUniformLocation(program, "LIGHT_TYPE");
-	LIGHT_LOCATION_vec3 = glGetUniformLocation(program, "LIGHT_LOCATION");
-	LIGHT_DIRECTION_vec3 = glGetUniformLocation(program, "LIGHT_DIRECTION");
-	LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "LIGHT_ENERGY");
-    AMBIENT_LIGHT_ENERGY_vec3 = glGetUniformLocation(program, "AMBIENT_LIGHT_ENERGY");
-    LIGHT_CUTOFF_float = glGetUniformLocation(program, "LIGHT_CUTOFF");
     SPECULAR_BRIGHTNESS_vec3 = glGetUniformLocation(program, "SPECULAR_BRIGHTNESS");
     SPECULAR_SHININESS_float = glGetUniformLocation(program, "SPECULAR_SHININESS");
 
-    WINDOW_DIMENSIONS = glGetUniformLocation(program, "WINDOW_DIMENSIONS");
-
 	draw_frame = glGetUniformLocation(program,"wireframe");
 
+	//point the uniform blocks at the shared buffers:
+	UniformBlocks::bind(program, UniformBlocks::ShadowLightBinding);
+
     GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
     GLuint SHADOW_DEPTH_sampler2D = glGetUniformLocation(program, "SHADOW_DEPTH");
 
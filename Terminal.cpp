@@ -22,12 +22,8 @@ Terminal::Terminal(size_t rows, size_t cols, glm::vec2 loc, glm::vec2 size,std::
         : text_display(rows, cols, loc, size,filepath) {}
 
 void Terminal::activate() {
-    add_component<EventHandler>([this](const SDL_Event &evt, const glm::uvec2 &window_size) {
-        if (evt.type == SDL_KEYDOWN) {
-            return handle_key(evt.key.keysym.sym);
-        } else {
-            return false;
-        }
+    add_component<EventHandler>(EventFilter{SDL_KEYDOWN, EventFilter::AnyKey, 10}, [this](const SDL_Event &evt, const glm::uvec2 &window_size) {
+        return handle_key(evt.key.keysym.sym);
     });
     text_display.activate();
 }
@@ -39,6 +35,8 @@ void Terminal::deactivate() {
 }
 
 bool Terminal::handle_key(SDL_Keycode key) {
+    // most keys edit the text below; the display re-uploads when it next draws
+    text_display.mark_text_changed();
     std::string keyname(SDL_GetKeyName(key));
     std::locale locale("C");
     if (key == SDLK_ESCAPE) {
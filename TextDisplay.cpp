@@ -13,26 +13,36 @@ TextDisplay::TextDisplay(size_t rows, size_t cols, glm::vec2 loc, glm::vec2 size
 
 void TextDisplay::activate() {
     add_component<Draw>([this]() {
-        // a stand-in for the background (possibly removable)
-        font.draw(' ', loc, size);
-        
-        for (size_t row = 0; row < rows; row++) {
-            for (size_t col = 0; col < cols; col++) {
-                char c = ' ';
-                if (row < text.size() && col < text[row].size()) {
-                    c = text[row][col];
+        // only rebuild the glyph quads when the text changed since the last upload
+        // (adding the component counts as a change, so this also runs on activation)
+        if (Draw::changed_since(id, mesh_tick)) {
+            mesh_tick = current_change_tick();
+            mesh.vertices.clear();
+            
+            // a stand-in for the background (possibly removable)
+            font.add_char(mesh, ' ', loc, size);
+            
+            for (size_t row = 0; row < rows; row++) {
+                for (size_t col = 0; col < cols; col++) {
+                    char c = ' ';
+                    if (row < text.size() && col < text[row].size()) {
+                        c = text[row][col];
+                    }
+                    auto char_size = glm::vec2(size.x / (float) cols, size.y / (float) rows);
+                    font.add_char(
+                            mesh,
+                            c,
+                            glm::vec2(
+                                    loc.x + (float) col * char_size.x,
+                                    loc.y + size.y - (float) row * char_size.y
+                            ),
+                            char_size
+                    );
                 }
-                auto char_size = glm::vec2(size.x / (float) cols, size.y / (float) rows);
-                font.draw(
-                        c,
-                        glm::vec2(
-                                loc.x + (float) col * char_size.x,
-                                loc.y + size.y - (float) row * char_size.y
-                        ),
-                        char_size
-                );
             }
+            font.upload(mesh);
         }
+        font.draw(mesh);
     });
 
     _is_activated = true;
@@ -80,6 +90,7 @@ void TextDisplay::add_text(const std::vector<std::string> &strs) {
     while (text.size() > rows) {
         text.erase(text.begin());
     }
+    mark_text_changed();
 }
 
 
@@ -89,5 +100,10 @@ bool TextDisplay::is_activated(){
 
 void TextDisplay::remove_all_text(){
     text.clear();
+    mark_text_changed();
     return;
+}
+
+void TextDisplay::mark_text_changed() {
+    Draw::mark_changed(id);
 }
\ No newline at end of file
@@ -20,6 +20,10 @@ struct TextDisplay : Entity {
 
     bool _is_activated;
     
+    /* text as uploaded to the GPU, rebuilt by the Draw component when it's been marked changed */
+    TextMesh mesh;
+    uint64_t mesh_tick = 0;
+    
     /*
      * Construct a text display of as many rows and columns of characters
      * at the specified location on screen (bottom left corner, coordinates in [-1, 1] x [-1, 1])
@@ -44,4 +48,10 @@ struct TextDisplay : Entity {
     bool is_activated();
 
     void remove_all_text();
+    
+    /*
+     * Call after modifying text directly, so the display gets re-uploaded
+     * (add_text and remove_all_text do this themselves)
+     */
+    void mark_text_changed();
 };
@@ -5,25 +5,23 @@ TextStorage::TextStorage(std::string filename){
 }
 
 void TextStorage::load(std::string filename){
-    std::ifstream file(filename,std::ios::binary);
-    std::vector<char> names;
-    std::vector<char> texts;
-    read_chunk(file,"str0",&names);
+    ChunkReader file(filename);
+    ChunkSpan<char> names = file.read<char>("str0");
 
-    read_chunk(file,"str1",&texts);
+    ChunkSpan<char> texts = file.read<char>("str1");
 
 
-    std::vector<TextHierarchyEntry> hierarchy;
-    read_chunk(file,"txth",&hierarchy);
+    ChunkSpan<TextHierarchyEntry> hierarchy = file.read<TextHierarchyEntry>("txth");
 
     for(auto &h : hierarchy){
-        std::string object_name,object_text;
+        //(views into the mapped file; only the split-up lines are copied out)
+        std::string_view object_name,object_text;
         if(h.name_begin <= h.name_end && h.name_end <= names.size()){
-            object_name = std::string(names.begin() + h.name_begin, names.begin() + h.name_end);
+            object_name = file.string(names, h.name_begin, h.name_end);
         }
 
         if(h.text_begin <= h.text_end && h.text_end <= texts.size()){
-            object_text = std::string(texts.begin() + h.text_begin, texts.begin() + h.text_end);
+            object_text = file.string(texts, h.text_begin, h.text_end);
         }
 
         std::vector<std::vector<std::string>> option_vector;
@@ -49,7 +47,7 @@ void TextStorage::load(std::string filename){
             // string of one option
             size_t index_begin = pos + option_delimiter.size();
             size_t length = pos_next - index_begin;
-            std::string option = object_text.substr(index_begin,length);
+            std::string_view option = object_text.substr(index_begin,length);
 
             pos = option.find(line_delimiter,0);
             while(pos!=std::string::npos){
@@ -68,15 +66,15 @@ void TextStorage::load(std::string filename){
 
                 index_begin = pos + line_delimiter.size();
                 length = pos_next - index_begin;
-                std::string line = option.substr(index_begin,length);
-                line_vector.push_back(line);
+                std::string_view line = option.substr(index_begin,length);
+                line_vector.emplace_back(line);
             }
 
             option_vector.push_back(line_vector);
         }
 
 
-        this->object_text_map[object_name] = option_vector;
+        this->object_text_map[std::string(object_name)] = option_vector;
 
     }
 
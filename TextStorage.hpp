@@ -1,6 +1,6 @@
 #include <string>
-#include "read_write_chunk.hpp"
-#include <fstream>
+#include "ChunkReader.hpp"
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
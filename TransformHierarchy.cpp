@@ -0,0 +1,210 @@
+#include "TransformHierarchy.hpp"
+
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TRANSFORM_HIERARCHY_SSE 1
+#endif
+
+void TransformHierarchy::resize(size_t count) {
+	size_t padded = (count + 3) / 4 * 4;
+	//padding lanes are identity transforms, so the four-wide kernel can run over them harmlessly:
+	px.assign(padded, 0.0f); py.assign(padded, 0.0f); pz.assign(padded, 0.0f);
+	qx.assign(padded, 0.0f); qy.assign(padded, 0.0f); qz.assign(padded, 0.0f); qw.assign(padded, 1.0f);
+	sx.assign(padded, 1.0f); sy.assign(padded, 1.0f); sz.assign(padded, 1.0f);
+	parent.assign(count, NoParent);
+
+	local_to_parent.resize(padded);
+	parent_to_local.resize(padded);
+	local_to_world.resize(count);
+	world_to_local.resize(count);
+}
+
+void TransformHierarchy::set(size_t i, glm::vec3 const &position, glm::quat const &rotation, glm::vec3 const &scale, uint32_t parent_) {
+	assert(i < size());
+	assert(parent_ == NoParent || parent_ < i);
+	px[i] = position.x; py[i] = position.y; pz[i] = position.z;
+	qx[i] = rotation.x; qy[i] = rotation.y; qz[i] = rotation.z; qw[i] = rotation.w;
+	sx[i] = scale.x; sy[i] = scale.y; sz[i] = scale.z;
+	parent[i] = parent_;
+}
+
+//--------------------------------------------------------------
+//local matrices; same math as Transform::make_local_to_parent / make_parent_to_local
+
+namespace {
+
+#ifdef TRANSFORM_HIERARCHY_SSE
+
+//columns are built as (x, y, z) registers holding four nodes each; this writes them out per node:
+void store_column(std::vector< TransformHierarchy::Affine > &out, size_t i, int column, __m128 x, __m128 y, __m128 z) {
+	__m128 w = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_store_ps(out[i + 0].c[column], x);
+	_mm_store_ps(out[i + 1].c[column], y);
+	_mm_store_ps(out[i + 2].c[column], z);
+	_mm_store_ps(out[i + 3].c[column], w);
+}
+
+//rotation matrix columns of quaternion (x, y, z, w), as glm::mat3_cast:
+void rotation_columns(__m128 x, __m128 y, __m128 z, __m128 w, __m128 r[3][3]) {
+	__m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+	__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+	__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+	__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+	r[0][0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+	r[0][1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+	r[0][2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+	r[1][0] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+	r[1][1] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+	r[1][2] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+	r[2][0] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+	r[2][1] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+	r[2][2] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+}
+
+//1/s, or 0 where s is 0 (degenerate rather than NaN, as in make_parent_to_local):
+__m128 safe_reciprocal(__m128 s) {
+	__m128 nonzero = _mm_cmpneq_ps(s, _mm_setzero_ps());
+	return _mm_and_ps(nonzero, _mm_div_ps(_mm_set1_ps(1.0f), s));
+}
+
+void compute_locals(TransformHierarchy &h) {
+	for (size_t i = 0; i < h.px.size(); i += 4) {
+		__m128 px = _mm_loadu_ps(&h.px[i]), py = _mm_loadu_ps(&h.py[i]), pz = _mm_loadu_ps(&h.pz[i]);
+		__m128 qx = _mm_loadu_ps(&h.qx[i]), qy = _mm_loadu_ps(&h.qy[i]), qz = _mm_loadu_ps(&h.qz[i]), qw = _mm_loadu_ps(&h.qw[i]);
+		__m128 s[3] = {_mm_loadu_ps(&h.sx[i]), _mm_loadu_ps(&h.sy[i]), _mm_loadu_ps(&h.sz[i])};
+
+		//local to parent: rotation columns scaled, then position:
+		__m128 r[3][3];
+		rotation_columns(qx, qy, qz, qw, r);
+		for (int c = 0; c < 3; ++c) {
+			store_column(h.local_to_parent, i, c, _mm_mul_ps(r[c][0], s[c]), _mm_mul_ps(r[c][1], s[c]), _mm_mul_ps(r[c][2], s[c]));
+		}
+		store_column(h.local_to_parent, i, 3, px, py, pz);
+
+		//parent to local: rotation of the inverse quaternion (conjugate / norm^2), rows scaled by 1/scale:
+		__m128 norm2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+		__m128 inv_norm2 = _mm_div_ps(_mm_set1_ps(1.0f), norm2);
+		__m128 neg_inv_norm2 = _mm_sub_ps(_mm_setzero_ps(), inv_norm2);
+		__m128 ir[3][3];
+		rotation_columns(_mm_mul_ps(qx, neg_inv_norm2), _mm_mul_ps(qy, neg_inv_norm2), _mm_mul_ps(qz, neg_inv_norm2), _mm_mul_ps(qw, inv_norm2), ir);
+		__m128 inv_s[3] = {safe_reciprocal(s[0]), safe_reciprocal(s[1]), safe_reciprocal(s[2])};
+		for (int c = 0; c < 3; ++c) {
+			for (int row = 0; row < 3; ++row) {
+				ir[c][row] = _mm_mul_ps(ir[c][row], inv_s[row]);
+			}
+			store_column(h.parent_to_local, i, c, ir[c][0], ir[c][1], ir[c][2]);
+		}
+		__m128 t[3];
+		for (int row = 0; row < 3; ++row) {
+			t[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ir[0][row], px), _mm_mul_ps(ir[1][row], py)), _mm_mul_ps(ir[2][row], pz));
+			t[row] = _mm_sub_ps(_mm_setzero_ps(), t[row]);
+		}
+		store_column(h.parent_to_local, i, 3, t[0], t[1], t[2]);
+	}
+}
+
+//out = a * b, treating both as 4x4 with a (0,0,0,1) bottom row:
+void compose(TransformHierarchy::Affine const &a, TransformHierarchy::Affine const &b, TransformHierarchy::Affine &out) {
+	__m128 a0 = _mm_load_ps(a.c[0]), a1 = _mm_load_ps(a.c[1]), a2 = _mm_load_ps(a.c[2]), a3 = _mm_load_ps(a.c[3]);
+	for (int k = 0; k < 4; ++k) {
+		__m128 col = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b.c[k][0])), _mm_mul_ps(a1, _mm_set1_ps(b.c[k][1]))),
+			_mm_mul_ps(a2, _mm_set1_ps(b.c[k][2]))
+		);
+		if (k == 3) col = _mm_add_ps(col, a3);
+		_mm_store_ps(out.c[k], col);
+	}
+}
+
+#else //scalar fallback (e.g. ARM)
+
+void rotation_columns(float x, float y, float z, float w, float r[3][3]) {
+	r[0][0] = 1.0f - 2.0f * (y * y + z * z);
+	r[0][1] = 2.0f * (x * y + w * z);
+	r[0][2] = 2.0f * (x * z - w * y);
+	r[1][0] = 2.0f * (x * y - w * z);
+	r[1][1] = 1.0f - 2.0f * (x * x + z * z);
+	r[1][2] = 2.0f * (y * z + w * x);
+	r[2][0] = 2.0f * (x * z + w * y);
+	r[2][1] = 2.0f * (y * z - w * x);
+	r[2][2] = 1.0f - 2.0f * (x * x + y * y);
+}
+
+void compute_locals(TransformHierarchy &h) {
+	for (size_t i = 0; i < h.px.size(); ++i) {
+		float p[3] = {h.px[i], h.py[i], h.pz[i]};
+		float s[3] = {h.sx[i], h.sy[i], h.sz[i]};
+		TransformHierarchy::Affine &l = h.local_to_parent[i];
+		TransformHierarchy::Affine &inv = h.parent_to_local[i];
+
+		float r[3][3];
+		rotation_columns(h.qx[i], h.qy[i], h.qz[i], h.qw[i], r);
+		for (int c = 0; c < 3; ++c) {
+			for (int row = 0; row < 3; ++row) l.c[c][row] = r[c][row] * s[c];
+			l.c[c][3] = 0.0f;
+		}
+		for (int row = 0; row < 3; ++row) l.c[3][row] = p[row];
+		l.c[3][3] = 0.0f;
+
+		float inv_norm2 = 1.0f / (h.qx[i] * h.qx[i] + h.qy[i] * h.qy[i] + h.qz[i] * h.qz[i] + h.qw[i] * h.qw[i]);
+		rotation_columns(-h.qx[i] * inv_norm2, -h.qy[i] * inv_norm2, -h.qz[i] * inv_norm2, h.qw[i] * inv_norm2, r);
+		for (int c = 0; c < 3; ++c) {
+			for (int row = 0; row < 3; ++row) inv.c[c][row] = r[c][row] * (s[row] == 0.0f ? 0.0f : 1.0f / s[row]);
+			inv.c[c][3] = 0.0f;
+		}
+		for (int row = 0; row < 3; ++row) {
+			inv.c[3][row] = -(inv.c[0][row] * p[0] + inv.c[1][row] * p[1] + inv.c[2][row] * p[2]);
+		}
+		inv.c[3][3] = 0.0f;
+	}
+}
+
+void compose(TransformHierarchy::Affine const &a, TransformHierarchy::Affine const &b, TransformHierarchy::Affine &out) {
+	for (int k = 0; k < 4; ++k) {
+		for (int row = 0; row < 4; ++row) {
+			out.c[k][row] = a.c[0][row] * b.c[k][0] + a.c[1][row] * b.c[k][1] + a.c[2][row] * b.c[k][2]
+				+ (k == 3 ? a.c[3][row] : 0.0f);
+		}
+	}
+}
+
+#endif
+
+glm::mat4x3 to_mat4x3(TransformHierarchy::Affine const &a) {
+	return glm::mat4x3(
+		glm::vec3(a.c[0][0], a.c[0][1], a.c[0][2]),
+		glm::vec3(a.c[1][0], a.c[1][1], a.c[1][2]),
+		glm::vec3(a.c[2][0], a.c[2][1], a.c[2][2]),
+		glm::vec3(a.c[3][0], a.c[3][1], a.c[3][2])
+	);
+}
+
+}
+
+//--------------------------------------------------------------
+
+void TransformHierarchy::compute() {
+	compute_locals(*this);
+
+	//parents come first, so one pass in order sees every parent already finished:
+	for (size_t i = 0; i < size(); ++i) {
+		if (parent[i] == NoParent) {
+			local_to_world[i] = local_to_parent[i];
+			world_to_local[i] = parent_to_local[i];
+		} else {
+			compose(local_to_world[parent[i]], local_to_parent[i], local_to_world[i]);
+			compose(parent_to_local[i], world_to_local[parent[i]], world_to_local[i]);
+		}
+	}
+}
+
+glm::mat4x3 TransformHierarchy::get_local_to_world(size_t i) const {
+	return to_mat4x3(local_to_world[i]);
+}
+
+glm::mat4x3 TransformHierarchy::get_world_to_local(size_t i) const {
+	return to_mat4x3(world_to_local[i]);
+}
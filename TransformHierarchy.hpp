@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+ * A flattened transform hierarchy: every node's local position/rotation/scale and parent index
+ * stored as parallel arrays, with parents always before their children, so all world matrices
+ * can be computed in one linear sweep:
+ *  - local-to-parent / parent-to-local matrices for four nodes at a time (SSE when available),
+ *  - then, in order, composing each node with its (already finished) parent.
+ *
+ * Scene::update_transforms() keeps one of these in sync with Scene::transforms.
+ */
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct TransformHierarchy {
+	static constexpr uint32_t NoParent = -1U;
+
+	//number of nodes; resize() invalidates the computed matrices:
+	size_t size() const { return parent.size(); }
+	void resize(size_t count);
+
+	//set node i's local transform; parent_ must be NoParent or less than i:
+	void set(size_t i, glm::vec3 const &position, glm::quat const &rotation, glm::vec3 const &scale, uint32_t parent_);
+
+	//compute every node's world matrices:
+	void compute();
+
+	//results of the last compute():
+	glm::mat4x3 get_local_to_world(size_t i) const;
+	glm::mat4x3 get_world_to_local(size_t i) const;
+
+	//--- storage ---
+	//inputs, one lane per node (padded with identity nodes to a multiple of four):
+	std::vector< float > px, py, pz;
+	std::vector< float > qx, qy, qz, qw;
+	std::vector< float > sx, sy, sz;
+	std::vector< uint32_t > parent;
+
+	//an affine 3x4 matrix as four padded columns, so a column is one SSE register:
+	struct alignas(16) Affine {
+		float c[4][4];
+	};
+	//scratch (local matrices) and outputs (world matrices):
+	std::vector< Affine > local_to_parent, parent_to_local;
+	std::vector< Affine > local_to_world, world_to_local;
+};
@@ -0,0 +1,101 @@
+#include "UniformBlocks.hpp"
+
+#include "gl_errors.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+char const *UniformBlocks::GLSL =
+	"layout(std140) uniform Camera {\n"
+	"	mat4 WORLD_TO_CLIP;\n"
+	"	mat4x3 WORLD_TO_LIGHT;\n"
+	"	vec3 VIEW_DIRECTION;\n"
+	"};\n"
+	"layout(std140) uniform Frame {\n"
+	"	vec4 WINDOW_DIMENSIONS;\n"
+	"};\n"
+	"layout(std140) uniform Light {\n"
+	"	int LIGHT_TYPE;\n"
+	"	float LIGHT_CUTOFF;\n"
+	"	vec3 LIGHT_LOCATION;\n"
+	"	vec3 LIGHT_DIRECTION;\n"
+	"	vec3 LIGHT_ENERGY;\n"
+	"	vec3 AMBIENT_LIGHT_ENERGY;\n"
+	"};\n";
+
+namespace {
+	//one buffer per binding point, along with what was last uploaded to it:
+	struct Block {
+		GLuint buffer = 0;
+		std::vector< uint8_t > contents;
+	};
+
+	//create every block's buffer (zero-filled) and attach it to its binding point, so that no
+	// block a program uses is ever unbacked, even if nothing has set it yet:
+	std::vector< Block > &blocks() {
+		static std::vector< Block > blocks;
+		if (blocks.empty()) {
+			blocks.resize(UniformBlocks::BindingCount);
+			for (GLuint binding = 0; binding < UniformBlocks::BindingCount; ++binding) {
+				size_t size = sizeof(UniformBlocks::Light);
+				if (binding == UniformBlocks::CameraBinding) size = sizeof(UniformBlocks::Camera);
+				if (binding == UniformBlocks::FrameBinding) size = sizeof(UniformBlocks::Frame);
+
+				Block &block = blocks[binding];
+				block.contents.assign(size, 0);
+				glGenBuffers(1, &block.buffer);
+				glBindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+				glBufferData(GL_UNIFORM_BUFFER, size, block.contents.data(), GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				glBindBufferBase(GL_UNIFORM_BUFFER, binding, block.buffer);
+			}
+			GL_ERRORS();
+		}
+		return blocks;
+	}
+
+	void upload(UniformBlocks::Binding binding, void const *data, size_t size) {
+		Block &block = blocks()[binding];
+		assert(block.contents.size() == size);
+		if (std::memcmp(block.contents.data(), data, size) == 0) return;
+		std::memcpy(block.contents.data(), data, size);
+
+		glBindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+}
+
+void UniformBlocks::bind(GLuint program, Binding light) {
+	assert(light >= LitLightBinding && light < BindingCount);
+	blocks(); //(make sure every binding point is backed)
+
+	auto bind_block = [program](char const *name, GLuint binding) {
+		GLuint index = glGetUniformBlockIndex(program, name);
+		if (index == GL_INVALID_INDEX) return; //(unused, or optimized out)
+		glUniformBlockBinding(program, index, binding);
+	};
+	bind_block("Camera", CameraBinding);
+	bind_block("Frame", FrameBinding);
+	bind_block("Light", light);
+
+	GL_ERRORS();
+}
+
+void UniformBlocks::set_camera(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) {
+	Camera camera;
+	camera.WORLD_TO_CLIP = world_to_clip;
+	camera.WORLD_TO_LIGHT = glm::mat4(world_to_light);
+	camera.VIEW_DIRECTION = glm::normalize(glm::inverse(glm::mat3(world_to_clip)) * glm::vec3(0.0f, 0.0f, 1.0f));
+	upload(CameraBinding, &camera, sizeof(camera));
+}
+
+void UniformBlocks::set_frame(Frame const &frame) {
+	upload(FrameBinding, &frame, sizeof(frame));
+}
+
+void UniformBlocks::set_light(Binding light, Light const &values) {
+	assert(light >= LitLightBinding && light < BindingCount);
+	upload(light, &values, sizeof(values));
+}
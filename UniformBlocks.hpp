@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+ * std140 uniform blocks shared by the scene programs (ComicBookProgram, ShadowProgram,
+ * RocketColorTextureProgram, ShadowMapProgram), so the values they have in common are uploaded
+ * once instead of with glUniform* calls per program (or per draw):
+ *  - Camera: WORLD_TO_CLIP / WORLD_TO_LIGHT / VIEW_DIRECTION of the pass being drawn (set by Scene::draw / draw_shadow)
+ *  - Frame: per-frame constants (set once per frame by PlayMode::draw)
+ *  - Light: a light rig; each program's "Light" block reads its own rig's binding point
+ *
+ * Each block lives in its own buffer, attached to its binding point once; the set_*() functions
+ * skip the upload if the contents haven't changed since the last one.
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+struct UniformBlocks {
+	//binding points:
+	enum Binding : GLuint {
+		CameraBinding = 0,
+		FrameBinding,
+		LitLightBinding, //ComicBookProgram
+		ShadowLightBinding, //ShadowProgram
+		RocketLightBinding, //RocketColorTextureProgram
+		BindingCount
+	};
+
+	//C++ mirrors of the GLSL blocks (std140 layout, hence the padding):
+	struct Camera {
+		glm::mat4 WORLD_TO_CLIP = glm::mat4(1.0f);
+		glm::mat4 WORLD_TO_LIGHT = glm::mat4(1.0f); //mat4x3 in GLSL, whose std140 columns are padded to vec4
+		//world-space direction the specular terms use as "toward the camera" (from WORLD_TO_CLIP, so it
+		// doesn't depend on how an object's vertices reach world space -- see Scene::StaticBatches):
+		glm::vec3 VIEW_DIRECTION = glm::vec3(0.0f, 0.0f, 1.0f);
+		float pad0 = 0.0f;
+	};
+	static_assert(sizeof(Camera) == 144, "Camera should match its std140 layout.");
+
+	struct Frame {
+		glm::vec4 WINDOW_DIMENSIONS = glm::vec4(0.0f); //drawable w, h, window w, h
+	};
+	static_assert(sizeof(Frame) == 16, "Frame should match its std140 layout.");
+
+	struct Light {
+		int32_t LIGHT_TYPE = 0; //0: point, 1: hemisphere, 2: spot, 3: directional
+		float LIGHT_CUTOFF = 1.0f;
+		float pad0[2] = {0.0f, 0.0f};
+		glm::vec3 LIGHT_LOCATION = glm::vec3(0.0f);
+		float pad1 = 0.0f;
+		glm::vec3 LIGHT_DIRECTION = glm::vec3(0.0f, 0.0f, -1.0f);
+		float pad2 = 0.0f;
+		glm::vec3 LIGHT_ENERGY = glm::vec3(1.0f);
+		float pad3 = 0.0f;
+		glm::vec3 AMBIENT_LIGHT_ENERGY = glm::vec3(0.0f);
+		float pad4 = 0.0f;
+	};
+	static_assert(sizeof(Light) == 80, "Light should match its std140 layout.");
+
+	//GLSL declarations of the blocks (put it right after the #version / #define lines of a shader):
+	static char const *GLSL;
+
+	//point a program's blocks at their binding points, with its "Light" block reading 'light'
+	// (blocks a program doesn't use, e.g. "Light" in ShadowMapProgram, are skipped; call once after linking):
+	static void bind(GLuint program, Binding light = LitLightBinding);
+
+	//update a block's contents:
+	static void set_camera(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light);
+	static void set_frame(Frame const &frame);
+	static void set_light(Binding light, Light const &values);
+};
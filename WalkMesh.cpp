@@ -1,12 +1,11 @@
 #include "WalkMesh.hpp"
 
-#include "read_write_chunk.hpp"
+#include "ChunkReader.hpp"
 
 #include <glm/gtx/norm.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 #include <iostream>
-#include <fstream>
 #include <algorithm>
 #include <string>
 
@@ -233,19 +232,15 @@ bool WalkMesh::cross_edge(WalkPoint const &start, WalkPoint *end_, glm::quat *ro
 
 
 WalkMeshes::WalkMeshes(std::string const &filename) {
-    std::ifstream file(filename, std::ios::binary);
+    ChunkReader file(filename);
     
-    std::vector<glm::vec3> vertices;
-    read_chunk(file, "p...", &vertices);
+    ChunkSpan<glm::vec3> vertices = file.read<glm::vec3>("p...");
     
-    std::vector<glm::vec3> normals;
-    read_chunk(file, "n...", &normals);
+    ChunkSpan<glm::vec3> normals = file.read<glm::vec3>("n...");
     
-    std::vector<glm::uvec3> triangles;
-    read_chunk(file, "tri0", &triangles);
+    ChunkSpan<glm::uvec3> triangles = file.read<glm::uvec3>("tri0");
     
-    std::vector<char> names;
-    read_chunk(file, "str0", &names);
+    ChunkSpan<char> names = file.read<char>("str0");
     
     struct IndexEntry {
         uint32_t name_begin, name_end;
@@ -253,10 +248,9 @@ WalkMeshes::WalkMeshes(std::string const &filename) {
         uint32_t triangle_begin, triangle_end;
     };
     
-    std::vector<IndexEntry> index;
-    read_chunk(file, "idxA", &index);
+    ChunkSpan<IndexEntry> index = file.read<IndexEntry>("idxA");
     
-    if (file.peek() != EOF) {
+    if (!file.at_end()) {
         std::cerr << "WARNING: trailing data in walkmesh file '" << filename << "'" << std::endl;
     }
     
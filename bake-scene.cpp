@@ -0,0 +1,66 @@
+/*
+ * bake-scene: precompute a level's scene setup (see BakedScene.hpp) so the game doesn't redo it
+ * at every launch.
+ *
+ * Usage: dist/bake-scene level.scene level.pnct level.baked
+ *
+ * Runs the same Scene setup the game does without baked data (initialize_scene_metadata,
+ * initialize_collider, initialize_text_collider, initialize_bread) and writes out the results.
+ * The game ignores a .baked file whose .scene or .pnct has changed since, so re-bake after
+ * re-exporting (scenes/Makefile does this).
+ */
+
+#include "BakedScene.hpp"
+#include "Mesh.hpp"
+#include "Scene.hpp"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char **argv) {
+	if (argc != 4) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <level.scene> <level.pnct> <out.baked>" << std::endl;
+		return 1;
+	}
+	std::string scene_file = argv[1];
+	std::string meshes_file = argv[2];
+	std::string baked_file = argv[3];
+
+	try {
+		//(no OpenGL here: the vertex data is never uploaded)
+		MeshBuffer meshes(meshes_file, MeshBuffer::DeferUpload());
+		meshes.register_names();
+
+		//every mesh gets a drawable (including the player, whose mesh the game swaps for the wizard):
+		Scene scene(scene_file, [](Scene &scene, Scene::Transform *transform, std::string const &) {
+			scene.drawables.emplace_back(std::make_shared< Scene::Drawable >(transform));
+		});
+
+		scene.initialize_scene_metadata();
+		scene.initialize_collider("col_", meshes);
+		scene.initialize_text_collider("text_", meshes);
+		scene.initialize_bread("bread_", meshes);
+
+		BakedScene::write(baked_file, scene, scene_file, meshes_file);
+
+		//read it back, as the game will:
+		BakedScene baked(baked_file);
+		for (auto const &t : baked.transforms) {
+			if (baked.find(baked.name(t.name_begin, t.name_end)) == BakedScene::Invalid) {
+				throw std::runtime_error("name table is missing a transform name");
+			}
+		}
+
+		std::cout << "Baked '" << baked_file << "': " << baked.transforms.size() << " transforms, "
+			<< baked.colliders.size() << " colliders (" << scene.colliders.size() << " plain, "
+			<< scene.terminals.size() << " terminal, " << scene.text_colliders.size() << " text, "
+			<< scene.bread_colliders.size() << " bread)." << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "Failed to bake '" << scene_file << "': " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,397 @@
+/*
+ * ecs-bench: microbenchmarks for the ECS.
+ *  - the sparse-set component storage (ECS/SparseSet.hpp) against the std::unordered_map
+ *    storage it replaced, for add / get / iterate / remove
+ *  - Entity-level operations (add/get/remove_component, system(), entity destruction),
+ *    both immediate and deferred because a system over the type is running
+ *  - HandlerComponent::handle_all dispatch through std::function vs. InplaceFunction
+ *
+ * Usage: dist/ecs-bench [--json results.json] [entity counts...]
+ *   (counts default to 1000 10000 100000 1000000)
+ *
+ * Every number is ns per operation. With --json, the same numbers are also written as
+ * {"results": [{"group", "variant", "entities", "op", "ns_per_op"}, ...]} so a run can be
+ * diffed against a baseline run.
+ */
+
+#include "ECS/Component.hpp"
+#include "ECS/Entity.hpp"
+#include "ECS/HandlerComponent.hpp"
+#include "ECS/View.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/* roughly the size of a small component: a transform-ish payload */
+struct Payload {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    float velocity[3] = {1.0f, 0.5f, 0.25f};
+    uint32_t flags = 0;
+};
+
+struct Timer {
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    double ns_per(size_t ops) const {
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / double(ops);
+    }
+};
+
+/* keeps the optimizer from discarding the work being measured */
+volatile float sink = 0.0f;
+
+void step(Payload &p) {
+    for (int i = 0; i < 3; ++i) p.position[i] += p.velocity[i] * 0.016f;
+    p.flags += 1;
+}
+
+struct Result {
+    double add, get, iterate, remove;
+};
+
+/* one measurement, as written to the JSON output */
+struct Record {
+    std::string group;
+    std::string variant;
+    size_t entities;
+    std::string op;
+    double ns_per_op;
+};
+
+std::vector<Record> records;
+
+void record(std::string group, std::string variant, size_t entities, std::string op, double ns) {
+    records.emplace_back(Record{std::move(group), std::move(variant), entities, std::move(op), ns});
+}
+
+void write_json(std::string const &path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("ecs-bench: failed to open '" + path + "' for writing.");
+    out << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        Record const &r = records[i];
+        out << "    {\"group\": \"" << r.group << "\", \"variant\": \"" << r.variant
+            << "\", \"entities\": " << r.entities << ", \"op\": \"" << r.op
+            << "\", \"ns_per_op\": " << r.ns_per_op << "}" << (i + 1 < records.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+Result bench_map(std::vector<uint32_t> const &ids, std::vector<uint32_t> const &lookups, int iterations) {
+    Result r{};
+    std::unordered_map<uint32_t, Payload> map;
+    {
+        Timer t;
+        for (uint32_t id: ids) map.emplace(id, Payload());
+        r.add = t.ns_per(ids.size());
+    }
+    {
+        Timer t;
+        float acc = 0.0f;
+        for (uint32_t id: lookups) {
+            auto f = map.find(id);
+            if (f != map.end()) acc += f->second.velocity[0];
+        }
+        sink = sink + acc;
+        r.get = t.ns_per(lookups.size());
+    }
+    {
+        Timer t;
+        for (int i = 0; i < iterations; ++i) {
+            for (auto &[_, p]: map) step(p);
+        }
+        r.iterate = t.ns_per(ids.size() * iterations);
+    }
+    {
+        Timer t;
+        for (uint32_t id: lookups) map.erase(id);
+        r.remove = t.ns_per(lookups.size());
+    }
+    return r;
+}
+
+Result bench_sparse(std::vector<uint32_t> const &ids, std::vector<uint32_t> const &lookups, int iterations) {
+    Result r{};
+    SparseSet<Payload> set;
+    {
+        Timer t;
+        for (uint32_t id: ids) set.emplace(id, Payload());
+        r.add = t.ns_per(ids.size());
+    }
+    {
+        Timer t;
+        float acc = 0.0f;
+        for (uint32_t id: lookups) {
+            if (Payload *p = set.find(id)) acc += p->velocity[0];
+        }
+        sink = sink + acc;
+        r.get = t.ns_per(lookups.size());
+    }
+    {
+        Timer t;
+        for (int i = 0; i < iterations; ++i) {
+            for (Payload &p: set) step(p);
+        }
+        r.iterate = t.ns_per(ids.size() * iterations);
+    }
+    {
+        Timer t;
+        for (uint32_t id: lookups) set.erase(id);
+        r.remove = t.ns_per(lookups.size());
+    }
+    return r;
+}
+
+/* Component<T>::system() over the sparse set, including the std::function call per element */
+struct BenchComponent : Component<BenchComponent> {
+    Payload payload;
+};
+
+double bench_system(std::vector<uint32_t> const &ids, int iterations, bool parallel) {
+    for (uint32_t id: ids) BenchComponent::get_storage().emplace(id);
+    Timer t;
+    for (int i = 0; i < iterations; ++i) {
+        if (parallel) {
+            BenchComponent::par_system([](BenchComponent &c) { step(c.payload); }, 4096);
+        } else {
+            BenchComponent::system([](BenchComponent &c) { step(c.payload); });
+        }
+    }
+    double ns = t.ns_per(ids.size() * iterations);
+    BenchComponent::get_storage().clear();
+    return ns;
+}
+
+/* a second component type, so destroyed entities have more than one component to remove */
+struct BenchTag : Component<BenchTag> {
+};
+
+struct EntityResult {
+    double add, get, system, remove, destroy;
+};
+
+/*
+ * Entity-level operations on count entities. With deferred set, each operation runs while a
+ * system over the component type is running, so adds/removes go through the deferred buffers
+ * and destroyed ids wait for the system to end; the time includes applying them at the end.
+ * In that mode "system" is a system() whose callback removes and re-adds every component.
+ */
+EntityResult bench_entities(size_t count, int iterations, bool deferred) {
+    EntityResult r{};
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.reserve(count);
+    for (size_t i = 0; i < count; ++i) entities.emplace_back(std::make_unique<Entity>());
+
+    /* ids are recycled, so look entities up by id rather than assuming they are 0..count-1 */
+    std::vector<Entity *> by_id;
+    for (auto &e: entities) {
+        if (by_id.size() <= e->id) by_id.resize(e->id + 1, nullptr);
+        by_id[e->id] = e.get();
+    }
+    std::vector<Entity *> shuffled(count);
+    for (size_t i = 0; i < count; ++i) shuffled[i] = entities[i].get();
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(0x15466));
+
+    {
+        Timer t;
+        {
+            std::unique_ptr<BenchComponent::SystemScope> scope;
+            if (deferred) scope = std::make_unique<BenchComponent::SystemScope>();
+            for (auto &e: entities) e->add_component<BenchComponent>();
+        }
+        r.add = t.ns_per(count);
+    }
+    for (auto &e: entities) e->add_component<BenchTag>();
+    {
+        Timer t;
+        float acc = 0.0f;
+        for (Entity *e: shuffled) {
+            if (BenchComponent *c = e->get_component<BenchComponent>()) acc += c->payload.velocity[0];
+        }
+        sink = sink + acc;
+        r.get = t.ns_per(count);
+    }
+    {
+        Timer t;
+        for (int i = 0; i < iterations; ++i) {
+            if (deferred) {
+                View<BenchComponent>::each([&](uint32_t id, BenchComponent &c) {
+                    step(c.payload);
+                    by_id[id]->remove_component<BenchComponent>();
+                    by_id[id]->add_component<BenchComponent>();
+                });
+            } else {
+                BenchComponent::system([](BenchComponent &c) { step(c.payload); });
+            }
+        }
+        r.system = t.ns_per(count * iterations);
+    }
+    {
+        Timer t;
+        {
+            std::unique_ptr<BenchComponent::SystemScope> scope;
+            if (deferred) scope = std::make_unique<BenchComponent::SystemScope>();
+            for (Entity *e: shuffled) e->remove_component<BenchComponent>();
+        }
+        r.remove = t.ns_per(count);
+    }
+    for (auto &e: entities) e->add_component<BenchComponent>();
+    {
+        Timer t;
+        {
+            std::unique_ptr<BenchComponent::SystemScope> scope;
+            std::unique_ptr<BenchTag::SystemScope> tag_scope;
+            if (deferred) {
+                scope = std::make_unique<BenchComponent::SystemScope>();
+                tag_scope = std::make_unique<BenchTag::SystemScope>();
+            }
+            entities.clear();
+        }
+        r.destroy = t.ns_per(count);
+    }
+    return r;
+}
+
+/* the same handlers stored both ways */
+struct FunctionHandler : HandlerComponent<FunctionHandler, void, float> {
+    using HandlerComponent<FunctionHandler, void, float>::HandlerComponent;
+};
+
+struct InplaceHandler : InplaceHandlerComponent<InplaceHandler, void, float> {
+    using InplaceHandlerComponent<InplaceHandler, void, float>::InplaceHandlerComponent;
+};
+
+/*
+ * small captures a single pointer (like the [this] handlers in the game); otherwise three
+ * pointers are captured (like main.cpp's [&] handlers), which std::function heap-allocates
+ */
+template<typename H>
+double bench_dispatch(std::vector<uint32_t> const &ids, int iterations, bool small) {
+    std::vector<Payload> payloads(ids.size());
+    float scale = 1.0f;
+    for (uint32_t id: ids) {
+        Payload *p = &payloads[id];
+        if (small) {
+            H::get_storage().emplace(id, [p](float dt) { p->position[0] += p->velocity[0] * dt; });
+        } else {
+            Payload *first = &payloads[0];
+            float *s = &scale;
+            H::get_storage().emplace(id, [p, first, s](float dt) { p->position[0] += first->velocity[0] * dt * *s; });
+        }
+    }
+    Timer t;
+    for (int i = 0; i < iterations; ++i) {
+        H::handle_all(0.016f);
+    }
+    double ns = t.ns_per(ids.size() * iterations);
+    H::get_storage().clear();
+    sink = sink + payloads[0].position[0];
+    return ns;
+}
+
+}
+
+int main(int argc, char **argv) {
+    auto usage = [&]() {
+        std::fprintf(stderr, "Usage: %s [--json results.json] [entity counts...]\n", argv[0]);
+        return 1;
+    };
+    std::string json_path;
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            if (i + 1 >= argc) return usage();
+            json_path = argv[++i];
+        } else {
+            //entity counts are positive integers:
+            if (arg.empty() || arg.find_first_not_of("0123456789") != std::string::npos) return usage();
+            size_t count;
+            try {
+                count = std::stoul(arg);
+            } catch (std::out_of_range const &) {
+                return usage();
+            }
+            if (count == 0) return usage();
+            counts.emplace_back(count);
+        }
+    }
+    if (counts.empty()) counts = {1000, 10000, 100000, 1000000};
+
+    std::printf("%10s %-8s %10s %10s %10s %10s %10s %10s\n", "entities", "storage", "add", "get", "iterate", "remove", "system", "par_system");
+    for (size_t count: counts) {
+        /* entity ids are handed out sequentially, but lookups come in arbitrary order */
+        std::vector<uint32_t> ids(count);
+        for (size_t i = 0; i < count; ++i) ids[i] = uint32_t(i);
+        std::vector<uint32_t> lookups = ids;
+        std::shuffle(lookups.begin(), lookups.end(), std::mt19937(0x15466));
+
+        int iterations = int(std::max<size_t>(1, 10000000 / count));
+
+        Result m = bench_map(ids, lookups, iterations);
+        Result s = bench_sparse(ids, lookups, iterations);
+        double sys = bench_system(ids, iterations, false);
+        double par_sys = bench_system(ids, iterations, true);
+
+        std::printf("%10zu %-8s %10.2f %10.2f %10.2f %10.2f %10s %10s\n", count, "map", m.add, m.get, m.iterate, m.remove, "-", "-");
+        std::printf("%10zu %-8s %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", count, "sparse", s.add, s.get, s.iterate, s.remove, sys, par_sys);
+        for (auto const &[variant, result]: {std::make_pair("map", m), std::make_pair("sparse", s)}) {
+            record("storage", variant, count, "add", result.add);
+            record("storage", variant, count, "get", result.get);
+            record("storage", variant, count, "iterate", result.iterate);
+            record("storage", variant, count, "remove", result.remove);
+        }
+        record("storage", "sparse", count, "system", sys);
+        record("storage", "sparse", count, "par_system", par_sys);
+    }
+    std::printf("(ns per operation; par_system on %zu threads)\n\n", ThreadPool::get().concurrency());
+
+    std::printf("%10s %-9s %10s %10s %10s %10s %10s\n", "entities", "mode", "add", "get", "system", "remove", "destroy");
+    for (size_t count: counts) {
+        int iterations = int(std::max<size_t>(1, 1000000 / count));
+        for (bool deferred: {false, true}) {
+            EntityResult e = bench_entities(count, iterations, deferred);
+            char const *mode = deferred ? "deferred" : "immediate";
+            std::printf("%10zu %-9s %10.2f %10.2f %10.2f %10.2f %10.2f\n", count, mode, e.add, e.get, e.system, e.remove, e.destroy);
+            record("entity", mode, count, "add_component", e.add);
+            record("entity", mode, count, "get_component", e.get);
+            record("entity", mode, count, "system", e.system);
+            record("entity", mode, count, "remove_component", e.remove);
+            record("entity", mode, count, "destroy", e.destroy);
+        }
+    }
+    std::printf("(ns per entity; deferred = inside a running system, including applying the changes after it)\n\n");
+
+    std::printf("%10s %-8s %14s %14s\n", "handlers", "capture", "std::function", "InplaceFunction");
+    for (size_t count: counts) {
+        std::vector<uint32_t> ids(count);
+        for (size_t i = 0; i < count; ++i) ids[i] = uint32_t(i);
+        int iterations = int(std::max<size_t>(1, 10000000 / count));
+        for (bool small: {true, false}) {
+            double function_dispatch = bench_dispatch<FunctionHandler>(ids, iterations, small);
+            double inplace_dispatch = bench_dispatch<InplaceHandler>(ids, iterations, small);
+            std::printf("%10zu %-8s %14.2f %14.2f\n", count, small ? "8B" : "24B", function_dispatch, inplace_dispatch);
+            std::string capture = small ? "8B" : "24B";
+            record("handle_all", "std::function/" + capture, count, "dispatch", function_dispatch);
+            record("handle_all", "InplaceFunction/" + capture, count, "dispatch", inplace_dispatch);
+        }
+    }
+    std::printf("(ns per handler per handle_all)\n");
+
+    if (!json_path.empty()) {
+        write_json(json_path);
+        std::printf("wrote %s\n", json_path.c_str());
+    }
+    return 0;
+}
@@ -140,19 +140,19 @@ int main(int argc, char **argv) {
     };
     on_resize();
     
-    Entity quit_handler, pause_handler;
-    quit_handler.add_component<EventHandler>([](const SDL_Event &evt, const glm::uvec2 &window_size) {
-        if (evt.type == SDL_QUIT) {
-            Mode::set_current(nullptr);
-            return true;
-        } else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_BACKQUOTE) {
-            SDL_SetRelativeMouseMode(SDL_FALSE);
-            return true;
-        }
-        return false;
+    //input handlers that live as long as the main loop (filters/priorities: see EventFilter):
+    Entity quit_handler, mouse_release_handler, pause_handler;
+    quit_handler.add_component<EventHandler>(EventFilter{SDL_QUIT, EventFilter::AnyKey, 100}, [](const SDL_Event &evt, const glm::uvec2 &window_size) {
+        Mode::set_current(nullptr);
+        return true;
+    });
+    
+    mouse_release_handler.add_component<EventHandler>(EventFilter{SDL_KEYDOWN, SDLK_BACKQUOTE, 100}, [](const SDL_Event &evt, const glm::uvec2 &window_size) {
+        SDL_SetRelativeMouseMode(SDL_FALSE);
+        return true;
     });
     
-    pause_handler.add_component<EventHandler>([&](const SDL_Event &evt, const glm::uvec2 &window_size) {
+    pause_handler.add_component<EventHandler>(EventFilter{SDL_KEYDOWN, EventFilter::AnyKey, 50}, [&](const SDL_Event &evt, const glm::uvec2 &window_size) {
         if (Mode::current == playmode && !playmode->terminal.text_display.is_activated()
             && evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_p) {
             Mode::set_current(pausemode);
@@ -194,8 +194,14 @@ int main(int argc, char **argv) {
         //  by performing three steps:
         
         { //(1) process any events that are pending
-            static SDL_Event evt;
-            while (SDL_PollEvent(&evt) == 1) {
+            //gather the frame's events first, so runs of mouse motion get dispatched once:
+            static EventBatch batch;
+            batch.clear();
+            static SDL_Event polled;
+            while (SDL_PollEvent(&polled) == 1) {
+                batch.push(polled);
+            }
+            for (SDL_Event const &evt: batch.events) {
                 //handle resizing:
                 if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
                     on_resize();
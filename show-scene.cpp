@@ -116,10 +116,10 @@ int main(int argc, char **argv) {
 
 				drawable->pipeline = show_scene_program_pipeline;
 
-				drawable->pipeline.vao = buffer_vao;
-				drawable->pipeline.type = mesh.type;
-				drawable->pipeline.start = mesh.start;
-				drawable->pipeline.count = mesh.count;
+				drawable->pipeline.write().vao = buffer_vao;
+				drawable->pipeline.write().type = mesh.type;
+				drawable->pipeline.write().start = mesh.start;
+				drawable->pipeline.write().count = mesh.count;
 
 			});
 		} catch (std::exception &e) {